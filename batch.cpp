@@ -0,0 +1,202 @@
+
+#include "horn.hpp"
+
+// A batch checks many sets of facts against the same rules. The rules are
+// compiled once, and at every size the saturation of the rules alone, T in
+// every interval and no facts, is found once for all the queries: it's part
+// of the saturation of every query at that size, so theirs start from it and
+// reach the same fixpoint, and a size where the rules alone reach a conflict
+// is refuted for every query without trying its starts. Every query goes
+// through the sizes from the smallest, so a seed is kept until the batch
+// ends; they are kept only while their total stays under the memory limit,
+// and a size past it is saturated from T by every query, as without a batch.
+
+// megabytes of seeds kept when the limits have no memory limit
+const double seedMemory = 1024;
+
+RuleBatch::RuleBatch(const InputClauses& phi, Case caseType, const Limits& limits)
+	: rules(phi), caseType(caseType), state{ caseType, rules }, limits(limits), min(0), max(-1), bytes(0) {
+	rules.facts.clear();
+	prepareState(state);
+	if (!checkSizes(caseType, rules.rules.size(), min, max)) return;
+	computed.reset(new std::once_flag[max - min + 1]);
+	seeds.resize(max - min + 1);
+}
+
+void RuleBatch::prepare(State& query) const {
+	query.boxa = state.boxa;
+	query.boxaBar = state.boxaBar;
+	query.program = state.program;
+
+	// the [A] and [P] facts the rules don't have are checked by extend() too
+	for (auto f : query.phi.facts) {
+		if (f.type != BOXA && f.type != BOXA_BAR) continue;
+		auto& boxes = f.type == BOXA ? query.boxa : query.boxaBar;
+		if (std::find(boxes.begin(), boxes.end(), f) == boxes.end()) boxes.push_back(f);
+	}
+	compileBoxes(query);
+	indexLiterals(query);
+}
+
+const RuleSeed *RuleBatch::seed(int d) {
+	int i = d - min;
+	std::call_once(computed[i], [&] {
+		// the other queries wait for it, so it has the limits of a query;
+		// the sizes can be computed at the same time, each with its own budget
+		Budget budget(limits);
+		State rulesOnly = state;
+		rulesOnly.budget = Budget::enabled(limits) ? &budget : nullptr;
+
+		// with no facts the start interval makes no difference
+		Model model = saturateAny(d, 0, 1, rulesOnly);
+		if (model.outcome == TIMEOUT || model.outcome == MEMOUT) return;
+
+		std::unique_ptr<RuleSeed> seed(new RuleSeed());
+		seed->conflict = model.outcome != SATISFIED;
+		if (!seed->conflict) {
+			seed->lo = std::move(model.lo);
+			int words = state.program.words;
+			seed->masks.assign((size_t)d * d * words, 0);
+			size_t size = (size_t)d * (d + 1) / 2 * sizeof(LabelSet) + seed->masks.size() * sizeof(uint64_t);
+			for (int z = 0; z < d - 1; z++) {
+				seed->lo.forEachInRow(z, z + 1, d, [&](int t, const LabelSet& labels) {
+					size += labels.size() * labelBytes;
+					if (!words) return;
+					uint64_t *mask = &seed->masks[((size_t)z * d + t) * words];
+					for (auto f : labels) {
+						int l = literalIndex(f);
+						mask[l >> 6] |= 1ULL << (l & 63);
+					}
+				});
+			}
+			if (bytes.fetch_add(size) + size > seedBytes()) {
+				bytes -= size;
+				return;
+			}
+		}
+		seeds[i] = std::move(seed);
+	});
+	return seeds[i].get();
+}
+
+size_t RuleBatch::seedBytes() const {
+	return (limits.memory > 0 ? limits.memory : seedMemory) * 1024 * 1024;
+}
+
+std::vector<BatchResult> checkBatch(RuleBatch& batch, const std::vector<FormulaVector>& queries, int threads, const Limits& limits) {
+	using namespace std::chrono;
+	std::vector<BatchResult> results(queries.size(), { Model::unsatisfied(), Stats(), 0 });
+	TaskPool pool(threads, 2 * threads);
+	for (size_t i = 0; i < queries.size(); i++) {
+		BatchResult *result = &results[i];
+		const FormulaVector *facts = &queries[i];
+		pool.submit([&batch, &limits, result, facts] {
+			InputClauses phi = batch.rules;
+			phi.facts = *facts;
+			auto t1 = high_resolution_clock::now();
+			result->model = check(phi, batch, &result->stats, limits);
+			auto t2 = high_resolution_clock::now();
+			result->time = (duration_cast<duration<double>>(t2 - t1)).count();
+		});
+	}
+	pool.wait();
+	return results;
+}
+
+std::vector<FormulaVector> parseQueries(const char *path, InputClauses& phi) {
+	std::ifstream fp(path);
+	std::cout << "Reading queries: " << path << "\n";
+	std::vector<FormulaVector> queries;
+	int lineNum = 0;
+	std::string line;
+
+	while (std::getline(fp, line)) {
+		auto cline = line.c_str();
+		TokInfo token = {};
+		lineNum++;
+
+		if (!findToken(cline, token)) continue;
+		if (cline[token.pos] == '#') continue;
+
+		FormulaVector facts;
+		do {
+			auto f = parseFormula(line, token, phi);
+			if (f.type == INVALID_FORMULA) exitError("This is not a valid formula.", lineNum, line.substr(token.pos, token.len));
+			facts.push_back(f);
+		} while (findToken(cline, token));
+		queries.push_back(facts);
+	}
+
+	return queries;
+}
+
+// the same outcome, start and labels in every interval
+bool sameModel(const Model& a, const Model& b) {
+	if (a.outcome != b.outcome) return false;
+	if (!a.satisfied) return true;
+	if (a.lo.size() != b.lo.size() || a.start != b.start) return false;
+	int d = a.lo.size();
+	bool same = true;
+	for (int z = 0; z < d - 1 && same; z++) {
+		a.lo.forEachInRow(z, z + 1, d, [&](int t, const LabelSet& labels) {
+			const LabelSet& other = b.lo.get(z, t);
+			if (labels.size() != other.size()) same = false;
+			for (auto f : labels) {
+				if (!same) return;
+				if (!other.count(f)) same = false;
+			}
+		});
+	}
+	return same;
+}
+
+int runBatch(InputClauses& phi, const std::vector<FormulaVector>& queries, const BatchOptions& options) {
+	using namespace std::chrono;
+	std::vector<Model> alone(queries.size(), Model::unsatisfied());
+
+	auto t1 = high_resolution_clock::now();
+	std::vector<BatchResult> runs;
+	{
+		RuleBatch batch(phi, options.caseType, options.limits);
+		runs = checkBatch(batch, queries, options.threads, options.limits);
+	}
+	auto t2 = high_resolution_clock::now();
+
+	// every query again as an input of its own, to compare the answers and the time
+	if (options.compare) {
+		TaskPool pool(options.threads, 2 * options.threads);
+		for (size_t i = 0; i < queries.size(); i++) {
+			Model *model = &alone[i];
+			const FormulaVector *facts = &queries[i];
+			pool.submit([&phi, &options, model, facts] {
+				InputClauses query = phi;
+				query.facts = *facts;
+				*model = check(query, options.caseType, nullptr, options.limits);
+			});
+		}
+		pool.wait();
+	}
+	auto t3 = high_resolution_clock::now();
+
+	printf("%s\t%s\t%s\t%s\t%s\t%s\n", "QUERY", "NUM_FACTS", "MODEL_SIZE", "SATISFIED", "TIME(s)", "SATURATIONS");
+	int differences = 0;
+	for (size_t i = 0; i < runs.size(); i++) {
+		auto& run = runs[i];
+		// a query over its limits in either run can't be compared
+		bool exceeded = run.model.outcome == TIMEOUT || run.model.outcome == MEMOUT ||
+			alone[i].outcome == TIMEOUT || alone[i].outcome == MEMOUT;
+		bool different = options.compare && !exceeded && !sameModel(run.model, alone[i]);
+		differences += different;
+		printf("%d\t%d\t%d\t%s\t%.7f\t%lld%s\n", (int)i, (int)queries[i].size(), (int)run.model.lo.size(),
+			outcomeStrings[run.model.outcome], run.time, run.stats.saturations, different ? "\tDIFFERENT" : "");
+	}
+
+	double batchTime = (duration_cast<duration<double>>(t2 - t1)).count();
+	printf("# %d queries in %.3f s as a batch", (int)runs.size(), batchTime);
+	if (options.compare) {
+		double aloneTime = (duration_cast<duration<double>>(t3 - t2)).count();
+		printf(", %.3f s alone, %d with a different model", aloneTime, differences);
+	}
+	printf("\n");
+	return differences > 0;
+}
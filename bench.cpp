@@ -0,0 +1,187 @@
+
+#include "horn.hpp"
+
+// the default corpus covers every case on a sample of the letter/clause
+// range swept by test.sh and test2.sh, up to 20 letters and 9 clauses
+const Case suiteCases[] = { FINITE, NATURAL, DISCRETE };
+const int suiteLetters[] = { 1, 2, 5, 10, 20 };
+const int suiteClauses[] = { 1, 3, 6, 9 };
+
+// every cell gets its own corpus, generated from the suite seed and the cell
+// parameters so that the instances don't depend on the order of the cells
+std::vector<InputClauses> suiteCorpus(const SuiteOptions& options, int letters, int clauses) {
+	std::seed_seq seq{ options.seed, (unsigned)letters, (unsigned)clauses };
+	rng.seed(seq);
+
+	std::vector<InputClauses> corpus(options.samples);
+	for (auto &phi : corpus) {
+		phi = randomInput2(clauses, letters);
+	}
+	return corpus;
+}
+
+double median(std::vector<double> v) {
+	if (v.size() == 0) return 0;
+	std::sort(v.begin(), v.end());
+	size_t mid = v.size() / 2;
+	if (v.size() % 2 == 1) return v[mid];
+	return (v[mid - 1] + v[mid]) / 2;
+}
+
+SuiteResult runSuiteCell(const SuiteOptions& options, Case caseType, int letters, int clauses) {
+	using namespace std::chrono;
+
+	auto corpus = suiteCorpus(options, letters, clauses);
+
+	SuiteResult result = {};
+	result.caseType = caseType;
+	result.letters = letters;
+	result.clauses = clauses;
+	result.samples = options.samples;
+
+	std::vector<double> times;
+	for (int run = 0; run < options.warmup + options.repeats; run++) {
+		int satisfied = 0;
+
+		auto t1 = high_resolution_clock::now();
+		for (auto &phi : corpus) {
+			Model model = check(phi, caseType);
+			if (model.satisfied) satisfied++;
+		}
+		auto t2 = high_resolution_clock::now();
+
+		result.satisfied = satisfied;
+		if (run >= options.warmup) {
+			times.push_back((duration_cast<duration<double>>(t2 - t1)).count());
+		}
+	}
+
+	// the spread is the median absolute deviation, which unlike the min-max
+	// range isn't thrown off by a single run hit by a context switch
+	result.median = median(times);
+	for (auto &t : times) {
+		t = std::abs(t - result.median);
+	}
+	result.spread = median(times);
+
+	// the models are verified once, out of the timed runs
+	for (auto &phi : corpus) {
+		Model model = check(phi, caseType);
+		if (!verifyModel(phi, caseType, model).empty()) result.invalid++;
+	}
+	return result;
+}
+
+bool sameCell(const SuiteResult& a, const SuiteResult& b) {
+	return a.caseType == b.caseType && a.letters == b.letters &&
+		a.clauses == b.clauses && a.samples == b.samples;
+}
+
+std::vector<SuiteResult> readBaseline(const std::string& path) {
+	std::vector<SuiteResult> baseline;
+	std::ifstream fp(path);
+	std::string line;
+	// the times only mean something on the machine that recorded them, so
+	// the baseline is recorded locally with make bench_baseline
+	if (!fp) {
+		fprintf(stderr, "No baseline in %s, record one with --save_baseline\n", path.c_str());
+		return baseline;
+	}
+
+	while (std::getline(fp, line)) {
+		if (line.empty() || line[0] == '#') continue;
+
+		char caseName[32];
+		SuiteResult r = {};
+		if (sscanf(line.c_str(), "%31s %d %d %d %d %lf %lf", caseName,
+			&r.letters, &r.clauses, &r.samples, &r.satisfied, &r.median, &r.spread) != 7) {
+			fprintf(stderr, "Skipping malformed baseline line: %s\n", line.c_str());
+			continue;
+		}
+		r.caseType = parseCaseType(caseName);
+		baseline.push_back(r);
+	}
+
+	return baseline;
+}
+
+bool writeBaseline(const std::string& path, const SuiteOptions& options, const std::vector<SuiteResult>& results) {
+	FILE *fp = fopen(path.c_str(), "w");
+	if (!fp) return false;
+
+	fprintf(fp, "# loghorn bench baseline, seed %u, %d warmup, %d repeats\n",
+		options.seed, options.warmup, options.repeats);
+	fprintf(fp, "# CASE LETTERS CLAUSES SAMPLES SATISFIED MEDIAN(s) SPREAD(s)\n");
+	for (auto &r : results) {
+		fprintf(fp, "%s %d %d %d %d %.7f %.7f\n", caseStrings[r.caseType],
+			r.letters, r.clauses, r.samples, r.satisfied, r.median, r.spread);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+int runBenchSuite(const SuiteOptions& options) {
+	std::vector<SuiteResult> baseline;
+	if (!options.baselineFile.empty()) {
+		baseline = readBaseline(options.baselineFile);
+	}
+
+	printf("%-9s %7s %7s %9s %11s %8s %11s %8s\n",
+		"CASE", "LETTERS", "CLAUSES", "SATISFIED", "MEDIAN(s)", "SPREAD", "BASELINE(s)", "CHANGE");
+
+	std::vector<SuiteResult> results;
+	int regressions = 0;
+	for (auto caseType : suiteCases) {
+		for (auto letters : suiteLetters) {
+			for (auto clauses : suiteClauses) {
+				auto r = runSuiteCell(options, caseType, letters, clauses);
+				results.push_back(r);
+
+				double spread = r.median > 0 ? r.spread / r.median : 0;
+				printf("%-9s %7d %7d %4d/%-4d %11.7f %7.1f%%", caseStrings[caseType],
+					letters, clauses, r.satisfied, r.samples, r.median, 100 * spread);
+
+				auto base = std::find_if(baseline.begin(), baseline.end(),
+					[&](const SuiteResult& b) { return sameCell(b, r); });
+				if (base == baseline.end()) {
+					printf(" %11s %8s", "-", "-");
+				} else {
+					double change = base->median > 0 ? r.median / base->median - 1 : 0;
+					printf(" %11.7f %+7.1f%%", base->median, 100 * change);
+
+					// a cell regresses when it is slower than the tolerance and the noise of both runs
+					double baseSpread = base->median > 0 ? base->spread / base->median : 0;
+					double threshold = std::max(options.tolerance, 2 * (spread + baseSpread));
+					if (base->satisfied != r.satisfied) {
+						printf("  ANSWERS CHANGED");
+						regressions++;
+					} else if (change > threshold) {
+						printf("  REGRESSION");
+						regressions++;
+					}
+				}
+
+				if (r.invalid > 0) {
+					printf("  INVALID MODELS");
+					regressions++;
+				}
+				printf("\n");
+			}
+		}
+	}
+
+	if (!options.saveBaselineFile.empty()) {
+		if (!writeBaseline(options.saveBaselineFile, options, results)) {
+			fprintf(stderr, "Can't write the baseline file %s\n", options.saveBaselineFile.c_str());
+			return 1;
+		}
+		printf("Baseline saved to %s\n", options.saveBaselineFile.c_str());
+	}
+
+	if (!baseline.empty()) {
+		printf("%d regression(s) against %s\n", regressions, options.baselineFile.c_str());
+	}
+
+	return regressions > 0;
+}
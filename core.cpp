@@ -0,0 +1,177 @@
+
+#include "horn.hpp"
+
+// The core is found by delta debugging on the rules and facts of the input:
+// the complements of smaller and smaller chunks are checked in parallel, and
+// a chunk is dropped as soon as the input stays unsatisfiable without it.
+// Adding rules or facts can only make an input unsatisfiable, so every
+// answer is kept and reused for all the subsets and supersets it decides.
+
+// one flag for every rule, followed by one for every fact
+typedef std::vector<char> Subset;
+
+struct CoreSearch {
+	InputClauses &phi;
+	Case caseType;
+	Limits limits;
+
+	std::mutex mutex;
+	std::vector<Subset> satisfiable, unsatisfiable;
+	long long checks, known, exceeded;
+
+	CoreSearch(InputClauses &phi, Case caseType, const Limits &limits)
+		: phi(phi), caseType(caseType), limits(limits), checks(0), known(0), exceeded(0) {}
+};
+
+bool isSubset(const Subset &a, const Subset &b) {
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i] && !b[i]) return false;
+	}
+	return true;
+}
+
+InputClauses subsetInput(const InputClauses &phi, const Subset &subset) {
+	InputClauses sub;
+	sub.labels = phi.labels;
+	for (size_t i = 0; i < phi.rules.size(); i++) {
+		if (subset[i]) sub.rules.push_back(phi.rules[i]);
+	}
+	for (size_t i = 0; i < phi.facts.size(); i++) {
+		if (subset[phi.rules.size() + i]) sub.facts.push_back(phi.facts[i]);
+	}
+	return sub;
+}
+
+bool coreUnsatisfiable(CoreSearch &search, const Subset &subset) {
+	{
+		std::lock_guard<std::mutex> lock(search.mutex);
+		for (auto &s : search.unsatisfiable) {
+			if (isSubset(s, subset)) { search.known++; return true; }
+		}
+		for (auto &s : search.satisfiable) {
+			if (isSubset(subset, s)) { search.known++; return false; }
+		}
+	}
+
+	auto sub = subsetInput(search.phi, subset);
+	Model model = check(sub, search.caseType, nullptr, search.limits);
+
+	// a check over the limits counts as satisfiable, so that nothing is
+	// dropped on a guess, but it isn't reused
+	std::lock_guard<std::mutex> lock(search.mutex);
+	search.checks++;
+	if (model.outcome == UNSATISFIED) {
+		search.unsatisfiable.push_back(subset);
+		return true;
+	}
+	if (model.outcome == SATISFIED) search.satisfiable.push_back(subset);
+	else search.exceeded++;
+	return false;
+}
+
+void coreWorker(CoreSearch &search, const std::vector<Subset> &tests, std::vector<char> &results, std::atomic<size_t> &next) {
+	for (size_t i = next++; i < tests.size(); i = next++) {
+		results[i] = coreUnsatisfiable(search, tests[i]);
+	}
+}
+
+std::vector<char> coreTests(CoreSearch &search, const std::vector<Subset> &tests, int threads) {
+	std::vector<char> results(tests.size());
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (int i = 1; i < std::min(threads, (int)tests.size()); i++) {
+		workers.push_back(std::thread(coreWorker, std::ref(search), std::cref(tests), std::ref(results), std::ref(next)));
+	}
+	coreWorker(search, tests, results, next);
+	for (auto &th : workers) {
+		th.join();
+	}
+	return results;
+}
+
+// returns false if the input isn't unsatisfiable, otherwise leaves a minimal
+// unsatisfiable subset in core
+bool unsatCore(CoreSearch &search, int threads, Subset &core) {
+	int n = search.phi.rules.size() + search.phi.facts.size();
+	core.assign(n, 1);
+	if (!coreUnsatisfiable(search, core)) return false;
+
+	// the elements that may still be dropped, the others are in every
+	// unsatisfiable subset of the current core
+	std::vector<int> candidates(n);
+	for (int i = 0; i < n; i++) candidates[i] = i;
+
+	size_t chunks = 2;
+	while (!candidates.empty()) {
+		chunks = std::min(chunks, candidates.size());
+
+		std::vector<std::vector<int>> parts(chunks);
+		for (size_t i = 0; i < candidates.size(); i++) {
+			parts[i * chunks / candidates.size()].push_back(candidates[i]);
+		}
+		std::vector<Subset> tests(chunks, core);
+		for (size_t c = 0; c < chunks; c++) {
+			for (auto i : parts[c]) tests[c][i] = 0;
+		}
+
+		auto results = coreTests(search, tests, threads);
+		auto first = std::find(results.begin(), results.end(), 1) - results.begin();
+		if (first < (int)chunks) {
+			core = tests[first];
+			std::vector<int> rest;
+			for (auto i : candidates) {
+				if (core[i]) rest.push_back(i);
+			}
+			candidates = rest;
+			chunks = std::max(chunks - 1, (size_t)2);
+			continue;
+		}
+
+		// the input is satisfiable without any of the single elements left
+		std::vector<int> rest;
+		for (auto &part : parts) {
+			if (part.size() > 1) rest.insert(rest.end(), part.begin(), part.end());
+		}
+		candidates = rest;
+		chunks *= 2;
+	}
+
+	return true;
+}
+
+int runUnsatCore(InputClauses &phi, const CoreOptions &options) {
+	using namespace std::chrono;
+
+	for (int c = FINITE; c <= DISCRETE; c++) {
+		Case caseType = (Case)c;
+		if (options.caseType != ALL_CASES && options.caseType != caseType) continue;
+
+		auto t1 = high_resolution_clock::now();
+		CoreSearch search(phi, caseType, options.limits);
+		Subset core;
+		bool unsatisfiable = unsatCore(search, options.threads, core);
+		auto t2 = high_resolution_clock::now();
+
+		if (!unsatisfiable) {
+			if (search.exceeded > 0) {
+				printf("The check of the %s case ran over the limits, there is no core\n", caseStrings[caseType]);
+			} else {
+				printf("The clause set is SATISFIABLE in the %s case, there is no core\n", caseStrings[caseType]);
+			}
+			continue;
+		}
+
+		auto sub = subsetInput(phi, core);
+		printf("Unsatisfiable core in the %s case: %d of %d rules, %d of %d facts\n", caseStrings[caseType],
+			(int)sub.rules.size(), (int)phi.rules.size(), (int)sub.facts.size(), (int)phi.facts.size());
+		printf("%lld checks, %lld answered by the subsets already checked, %.7fs\n",
+			search.checks, search.known, (duration_cast<duration<double>>(t2 - t1)).count());
+		if (search.exceeded > 0) {
+			printf("%lld checks ran over the limits, the core may not be minimal\n", search.exceeded);
+		}
+		writeHorn(stdout, sub);
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,182 @@
+
+#include "horn.hpp"
+
+// The differential mode runs the reference engine and check() on the same
+// inputs and stops at the first input where the answers differ, in
+// satisfiability, size of the minimal model or starting interval.
+
+enum DiffResult { AGREED, DISAGREED, SKIPPED };
+
+struct DiffRun {
+	std::atomic<long long> next;
+	std::atomic<bool> stop;
+	std::mutex mutex;
+	long long compared = 0;
+	long long skipped = 0;
+	double referenceTime = 0;
+	double engineTime = 0;
+
+	// the first disagreement found
+	bool found = false;
+	InputClauses input;
+	Case caseType;
+	std::string reference, engine, origin;
+
+	DiffRun() : next(0), stop(false) {}
+};
+
+std::string modelString(const Model &model) {
+	switch (model.outcome) {
+		case SATISFIED:
+			return "SATISFIABLE, size " + std::to_string(model.lo.size()) +
+				", start " + intervalString(model.start.first, model.start.second);
+		case UNSATISFIED: return "NOT SATISFIABLE";
+		default: return outcomeStrings[model.outcome];
+	}
+}
+
+bool sameAnswer(const Model &a, const Model &b) {
+	if (a.outcome != b.outcome) return false;
+	if (!a.satisfied) return true;
+	// the reference engine tries the starts in the lexicographic order, so
+	// with any other order only the size has to match
+	if (a.lo.size() != b.lo.size()) return false;
+	return candidate_order != ORDER_LEX || a.start == b.start;
+}
+
+DiffResult diffCase(InputClauses &phi, Case caseType, const std::string &origin, const DiffOptions &options, DiffRun &run) {
+	using namespace std::chrono;
+
+	auto t1 = high_resolution_clock::now();
+	Model reference = referenceCheck(phi, caseType, options.limits);
+	auto t2 = high_resolution_clock::now();
+	Model model = check(phi, caseType, nullptr, options.limits);
+	auto t3 = high_resolution_clock::now();
+
+	// an input over the limits of either engine has nothing to compare
+	bool exceeded = reference.outcome == TIMEOUT || reference.outcome == MEMOUT ||
+		model.outcome == TIMEOUT || model.outcome == MEMOUT;
+	DiffResult result = exceeded ? SKIPPED : sameAnswer(reference, model) ? AGREED : DISAGREED;
+
+	std::lock_guard<std::mutex> lock(run.mutex);
+	run.referenceTime += (duration_cast<duration<double>>(t2 - t1)).count();
+	run.engineTime += (duration_cast<duration<double>>(t3 - t2)).count();
+	if (result == SKIPPED) run.skipped++;
+	else run.compared++;
+
+	if (result == DISAGREED && !run.found) {
+		run.found = true;
+		run.input = phi;
+		run.caseType = caseType;
+		run.reference = modelString(reference);
+		run.engine = modelString(model);
+		run.origin = origin;
+		run.stop = true;
+	}
+	return result;
+}
+
+void diffInput(InputClauses &phi, const std::string &origin, const DiffOptions &options, DiffRun &run) {
+	for (int c = FINITE; c <= DISCRETE; c++) {
+		Case caseType = (Case)c;
+		if (options.caseType != ALL_CASES && options.caseType != caseType) continue;
+
+		if (diffCase(phi, caseType, origin, options, run) == DISAGREED) return;
+	}
+}
+
+void diffGeneratedWorker(const DiffOptions &options, DiffRun &run) {
+	for (long long i = run.next++; i < options.instances && !run.stop; i = run.next++) {
+		auto phi = seededInput(options.seed, options.letters, options.clauses, i);
+		diffInput(phi, "instance " + std::to_string(i) + " generated with seed " + std::to_string(options.seed) +
+			", " + std::to_string(options.letters) + " letters, " + std::to_string(options.clauses) + " clauses",
+			options, run);
+	}
+}
+
+// the workers split the inputs by their first clause, like the enumeration mode
+void diffEnumeratedWorker(const DiffOptions &options, const InputClauses &inputTemplate,
+	std::vector<Clause> &clauses, const std::vector<std::vector<int>> &renamings, DiffRun &run) {
+	int numClauses = clauses.size();
+	for (int first = run.next++; first < numClauses && !run.stop; first = run.next++) {
+		std::vector<int> subset = { first };
+		do {
+			if (!isCanonical(subset, renamings)) continue;
+
+			std::string origin = "enumerated input with clauses";
+			for (auto i : subset) origin += " " + std::to_string(i);
+			auto phi = enumeratedInput(inputTemplate, clauses, subset);
+			diffInput(phi, origin, options, run);
+
+		} while (!run.stop && nextSubset(subset, numClauses, options.clauses) && subset[0] == first);
+	}
+}
+
+bool writeDisagreement(const DiffOptions &options, const DiffRun &run) {
+	FILE *fp = fopen(options.outputFile.c_str(), "w");
+	if (!fp) return false;
+
+	fprintf(fp, "# the reference engine and check() disagree in the %s case\n", caseStrings[run.caseType]);
+	fprintf(fp, "# %s\n", run.origin.c_str());
+	fprintf(fp, "# reference: %s\n", run.reference.c_str());
+	fprintf(fp, "# check: %s\n", run.engine.c_str());
+	writeHorn(fp, run.input);
+
+	fclose(fp);
+	return true;
+}
+
+int runDiff(const DiffOptions &options) {
+	DiffRun run;
+	std::vector<std::thread> threads;
+	std::vector<Clause> clauses;
+	InputClauses inputTemplate;
+	std::vector<std::vector<int>> renamings;
+
+	if (!options.inputFile.empty()) {
+		auto phi = parseFile(options.inputFile.c_str());
+		diffInput(phi, "read from " + options.inputFile, options, run);
+
+	} else if (options.enumerate) {
+		inputTemplate = enumerationTemplate(options.letters, clauses);
+		renamings = clauseRenamings(clauses, options.letters);
+
+		printf("Comparing the engines on all the inputs with up to %d clauses over %d letters\n",
+			options.clauses, options.letters);
+		for (int i = 0; i < options.threads; i++) {
+			threads.push_back(std::thread(diffEnumeratedWorker, std::cref(options), std::cref(inputTemplate),
+				std::ref(clauses), std::cref(renamings), std::ref(run)));
+		}
+
+	} else {
+		printf("Comparing the engines on %lld inputs with %d clauses over %d letters, seed %u\n",
+			options.instances, options.clauses, options.letters, options.seed);
+		for (int i = 0; i < options.threads; i++) {
+			threads.push_back(std::thread(diffGeneratedWorker, std::cref(options), std::ref(run)));
+		}
+	}
+
+	for (auto &th : threads) {
+		th.join();
+	}
+
+	printf("Compared %lld checks, %lld skipped over the limits\n", run.compared, run.skipped);
+	printf("Reference engine: %.7fs, check(): %.7fs, speedup %.2fx\n", run.referenceTime, run.engineTime,
+		run.engineTime > 0 ? run.referenceTime / run.engineTime : 0);
+
+	if (!run.found) {
+		printf("No disagreements\n");
+		return 0;
+	}
+
+	printf("DISAGREEMENT in the %s case, %s\n", caseStrings[run.caseType], run.origin.c_str());
+	printf("reference: %s\n", run.reference.c_str());
+	printf("check: %s\n", run.engine.c_str());
+	writeHorn(stdout, run.input);
+	if (!writeDisagreement(options, run)) {
+		fprintf(stderr, "Can't write the input to %s\n", options.outputFile.c_str());
+	} else {
+		printf("Input written to %s\n", options.outputFile.c_str());
+	}
+	return 1;
+}
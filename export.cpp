@@ -0,0 +1,155 @@
+
+#include "horn.hpp"
+
+// the POSIX calls are prefixed on Windows
+#ifdef _MSC_VER
+inline long long writeFd(int fd, const char *data, size_t len) { return _write(fd, data, (unsigned)len); }
+inline int openFd(const char *path) { return _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644); }
+inline void closeFd(int fd) { _close(fd); }
+#else
+inline long long writeFd(int fd, const char *data, size_t len) { return ::write(fd, data, len); }
+inline int openFd(const char *path) { return ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+inline void closeFd(int fd) { ::close(fd); }
+#endif
+
+void OutputBuffer::flush() {
+	if (data.empty()) return;
+	// anything printed before must come first
+	if (fd == 1) fflush(stdout);
+
+	size_t done = 0;
+	while (done < data.size()) {
+		auto n = writeFd(fd, data.data() + done, data.size() - done);
+		if (n <= 0) break;
+		done += n;
+	}
+	data.clear();
+}
+
+ExportFormat parseExportFormat(const std::string& name) {
+	for (int i = 0; i < INVALID_EXPORT; i++) {
+		if (name == exportFormatStrings[i]) return (ExportFormat)i;
+	}
+	return INVALID_EXPORT;
+}
+
+int openExport(const std::string& path) {
+	if (path == "-") return 1;
+	return openFd(path.c_str());
+}
+
+void closeExport(int fd) {
+	if (fd > 2) closeFd(fd);
+}
+
+void ModelExporter::begin(Case caseType, int d, Interval start) {
+	this->d = d;
+	this->start = start;
+	written = IntervalVector<LabelSet>();
+
+	switch (format) {
+		case EXPORT_TEXT:
+			out.put("Model of size "); out.put(d);
+			out.put(" in the "); out.put(caseStrings[caseType]);
+			out.put(" case, starting interval ["); out.put(start.first);
+			out.put(", "); out.put(start.second); out.put("]\n");
+			break;
+		case EXPORT_JSON:
+			out.put("{\"case\":\""); out.put(caseStrings[caseType]);
+			out.put("\",\"size\":"); out.put(d);
+			out.put(",\"start\":["); out.put(start.first);
+			out.put(','); out.put(start.second); out.put("]}\n");
+			break;
+		case EXPORT_DOT:
+			out.put("digraph model {\n\tlabel=\""); out.put(caseStrings[caseType]);
+			out.put(" model of size "); out.put(d); out.put("\";\n\trankdir=LR;\n");
+			for (int z = 0; z < d; z++) {
+				out.put('\t'); out.put(z); out.put(";\n");
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+// the labels are alphanumeric, so they never need escaping
+void ModelExporter::label(Formula f) {
+	if (f.type == BOXA) out.put("[A]");
+	else if (f.type == BOXA_BAR) out.put("[P]");
+	out.put(phi.labels[f.id]);
+}
+
+void ModelExporter::interval(int z, int t, int pass) {
+	switch (format) {
+		case EXPORT_TEXT:
+			out.put('['); out.put(z); out.put(", "); out.put(t); out.put("]:");
+			for (auto f : added) {
+				out.put("\n\t");
+				label(f);
+			}
+			out.put('\n');
+			break;
+		case EXPORT_JSON:
+			out.put('{');
+			if (pass >= 0) {
+				out.put("\"pass\":"); out.put(pass); out.put(',');
+			}
+			out.put("\"interval\":["); out.put(z); out.put(','); out.put(t); out.put("],\"labels\":[");
+			for (size_t i = 0; i < added.size(); i++) {
+				if (i > 0) out.put(',');
+				out.put('"');
+				label(added[i]);
+				out.put('"');
+			}
+			out.put("]}\n");
+			break;
+		case EXPORT_DOT:
+			out.put('\t'); out.put(z); out.put(" -> "); out.put(t); out.put(" [label=\"");
+			for (size_t i = 0; i < added.size(); i++) {
+				if (i > 0) out.put("\\n");
+				label(added[i]);
+			}
+			out.put('"');
+			if (pass >= 0) {
+				out.put(", comment=\"pass "); out.put(pass); out.put('"');
+			}
+			if (z == start.first && t == start.second) out.put(", style=bold");
+			out.put("];\n");
+			break;
+		default:
+			break;
+	}
+}
+
+void ModelExporter::write(const IntervalVector<LabelSet>& lo, int pass) {
+	if (format == EXPORT_TEXT && pass >= 0) {
+		out.put("pass "); out.put(pass); out.put(":\n");
+	}
+	// every pass writes only the labels the ones before it didn't, a single
+	// write has them all and keeps no copy
+	bool passes = pass >= 0;
+	if (passes && (int)written.size() != d) written = IntervalVector<LabelSet>(d);
+
+	for (int z = 0; z < d - 1; z++) {
+		lo.forEachInRow(z, z + 1, d, [&](int t, const LabelSet& labels) {
+			added.clear();
+			for (auto f : labels) {
+				if (f.type == CLAUSE) continue;
+				if (!passes || written.get(z, t).insert(f)) added.push_back(f);
+			}
+			if (added.empty()) return;
+
+			// the sets have no order of their own, this keeps the output stable
+			std::sort(added.begin(), added.end(), [](Formula a, Formula b) {
+				return literalIndex(a) < literalIndex(b);
+			});
+			interval(z, t, pass);
+		});
+	}
+}
+
+void ModelExporter::end() {
+	if (format == EXPORT_DOT) out.put("}\n");
+	if (format == EXPORT_TEXT) out.put('\n');
+	out.flush();
+}
@@ -0,0 +1,225 @@
+
+#include "horn.hpp"
+
+// Structured families of inputs whose minimal model grows with a parameter
+// n >= 1, with the size every case is expected to find. They are built from
+// two chains: [A]F holds in the intervals ending at the last point, and
+// g1 <- [A]F, gk <- [A]g(k-1), gk <- g(k-1) makes gk hold in the intervals
+// ending in the last k points; the same with [P] makes hk hold in the ones
+// starting in the first k points. The fact a is then kept away from the ends:
+//
+//   after       a & gn -> F, n points after the start interval
+//   before      a & hn -> F, n points before it
+//   nested      both, 2n points around it
+//   split       a & gi & h(n+1-i) -> F for every i, n points split in any way
+//               between the two sides
+//   edge_sat    after, with a -> [A]c1, ck -> [A]c(k+1), c(m+1) -> F capping
+//               the points after the start interval at m = n
+//   edge_unsat  the same with the cap at m = n - 1, one point short
+//
+// Only the finite case grows in every family. The infinite cases never have
+// [A]F, so the g chains stay empty: in the natural case after and split stay
+// at 3 and only before and nested grow, as n + 3, on the hk from [P]F. The
+// discrete case never has [P]F either, so every family stays at 4 there, and
+// the caps can't be met in either infinite case. A discrete family would have
+// to count points from something other than an end, and [A] and [P] over the
+// Horn rules have nothing else to anchor a chain to.
+
+const char *familyStrings[] = {
+	"after",
+	"before",
+	"nested",
+	"split",
+	"edge_sat",
+	"edge_unsat",
+};
+
+Family parseFamily(const std::string& name) {
+	for (int i = 0; i < INVALID_FAMILY; i++) {
+		if (name == familyStrings[i]) return (Family)i;
+	}
+	return INVALID_FAMILY;
+}
+
+bool parseFamilies(const std::string& value, std::vector<Family>& out) {
+	out.clear();
+	std::stringstream items(value);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		if (item == "all") {
+			for (int i = 0; i < INVALID_FAMILY; i++) out.push_back((Family)i);
+			continue;
+		}
+		Family family = parseFamily(item);
+		if (family == INVALID_FAMILY) return false;
+		out.push_back(family);
+	}
+	return !out.empty();
+}
+
+struct FamilyBuilder {
+	InputClauses phi = {};
+
+	FamilyBuilder() {
+		phi.labels.push_back("F");
+		phi.labels.push_back("T");
+	}
+
+	int letter(const std::string& name) {
+		auto it = std::find(phi.labels.begin(), phi.labels.end(), name);
+		if (it != phi.labels.end()) return it - phi.labels.begin();
+		phi.labels.push_back(name);
+		return phi.labels.size() - 1;
+	}
+	Formula get(FormulaType type, const std::string& name) {
+		return Formula::create(type, name == "F" ? FALSEHOOD : letter(name));
+	}
+	void rule(std::initializer_list<Formula> clause) {
+		phi.rules.push_back(Clause(clause));
+	}
+
+	// prefix1..prefixn, each holding in the intervals ending (or starting)
+	// in the last (or first) k points
+	void chain(FormulaType box, const std::string& prefix, int n) {
+		rule({ get(box, "F"), get(LETTER, prefix + "1") });
+		for (int k = 2; k <= n; k++) {
+			std::string previous = prefix + std::to_string(k - 1), next = prefix + std::to_string(k);
+			rule({ get(box, previous), get(LETTER, next) });
+			rule({ get(LETTER, previous), get(LETTER, next) });
+		}
+	}
+
+	// at most cap points after the start interval: ck holds in the intervals
+	// starting k - 1 points after it
+	void cap(int cap) {
+		rule({ get(LETTER, "a"), get(BOXA, "c1") });
+		for (int k = 1; k <= cap; k++) {
+			rule({ get(LETTER, "c" + std::to_string(k)), get(BOXA, "c" + std::to_string(k + 1)) });
+		}
+		rule({ get(LETTER, "c" + std::to_string(cap + 1)), Formula::falsehood() });
+	}
+};
+
+InputClauses familyInput(Family family, int n) {
+	FamilyBuilder b;
+	b.phi.facts.push_back(b.get(LETTER, "a"));
+	Formula a = b.get(LETTER, "a");
+	std::string last = std::to_string(n);
+
+	if (family != BEFORE_FAMILY) b.chain(BOXA, "g", n);
+	if (family == BEFORE_FAMILY || family == NESTED_FAMILY || family == SPLIT_FAMILY) b.chain(BOXA_BAR, "h", n);
+
+	if (family == SPLIT_FAMILY) {
+		for (int i = 1; i <= n; i++) {
+			b.rule({ a, b.get(LETTER, "g" + std::to_string(i)), b.get(LETTER, "h" + std::to_string(n + 1 - i)), Formula::falsehood() });
+		}
+	} else {
+		if (family != BEFORE_FAMILY) b.rule({ a, b.get(LETTER, "g" + last), Formula::falsehood() });
+		if (family == BEFORE_FAMILY || family == NESTED_FAMILY) b.rule({ a, b.get(LETTER, "h" + last), Formula::falsehood() });
+	}
+
+	if (family == EDGE_SAT_FAMILY) b.cap(n);
+	if (family == EDGE_UNSAT_FAMILY) b.cap(n - 1);
+	return b.phi;
+}
+
+// the size of the minimal model, 0 if there is none
+int familyExpectedSize(Family family, Case caseType, int n) {
+	switch (caseType) {
+		case FINITE:
+			if (family == EDGE_UNSAT_FAMILY) return 0;
+			return family == NESTED_FAMILY ? 2 * n + 2 : n + 2;
+		case NATURAL:
+			if (family == EDGE_SAT_FAMILY || family == EDGE_UNSAT_FAMILY) return 0;
+			return family == BEFORE_FAMILY || family == NESTED_FAMILY ? n + 3 : 3;
+		case DISCRETE:
+			if (family == EDGE_SAT_FAMILY || family == EDGE_UNSAT_FAMILY) return 0;
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+struct FamilyRun {
+	Family family;
+	Case caseType;
+	int n;
+	int letters, clauses;
+	int expected;
+	Model model;
+	Stats stats;
+	double time;
+};
+
+void familyCheck(const FamilyOptions& options, FamilyRun& run) {
+	using namespace std::chrono;
+	InputClauses phi = familyInput(run.family, run.n);
+	run.letters = phi.labels.size() - 2;
+	run.clauses = phi.rules.size();
+	run.stats = Stats();
+
+	auto t1 = high_resolution_clock::now();
+	run.model = check(phi, run.caseType, &run.stats, options.limits);
+	auto t2 = high_resolution_clock::now();
+	run.time = (duration_cast<duration<double>>(t2 - t1)).count();
+}
+
+bool familyExceeded(const FamilyRun& run) {
+	return run.model.outcome == TIMEOUT || run.model.outcome == MEMOUT;
+}
+
+// a run over its limits isn't a wrong size, but it fails the run all the same
+bool familyMismatch(const FamilyRun& run) {
+	if (familyExceeded(run)) return false;
+	int size = run.model.outcome == SATISFIED ? (int)run.model.lo.size() : 0;
+	return size != run.expected;
+}
+
+int runFamilies(const FamilyOptions& options) {
+	std::vector<FamilyRun> runs;
+	for (auto family : options.families) {
+		for (auto caseType : options.cases) {
+			for (auto n : options.params) {
+				runs.push_back({ family, caseType, n, 0, 0, familyExpectedSize(family, caseType, n), Model::unsatisfied(), Stats(), 0 });
+			}
+		}
+	}
+
+	if (!options.writePrefix.empty()) {
+		for (auto family : options.families) {
+			for (auto n : options.params) {
+				std::string path = options.writePrefix + "-" + familyStrings[family] + "-" + std::to_string(n) + ".horn";
+				FILE *fp = fopen(path.c_str(), "w");
+				if (!fp) {
+					fprintf(stderr, "Can't write the instance to %s\n", path.c_str());
+					return 1;
+				}
+				writeHorn(fp, familyInput(family, n));
+				fclose(fp);
+			}
+		}
+	}
+
+	{
+		TaskPool pool(options.threads, 2 * options.threads);
+		for (auto &run : runs) {
+			FamilyRun *target = &run;
+			pool.submit([&options, target] { familyCheck(options, *target); });
+		}
+		pool.wait();
+	}
+
+	printf("%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n", "FAMILY", "N", "CASE", "NUM_LETTERS", "NUM_CLAUSES",
+		"EXPECTED", "MODEL_SIZE", "SATISFIED", "TIME(s)", "SATURATIONS");
+	int mismatches = 0, exceeded = 0;
+	for (auto &run : runs) {
+		bool mismatch = familyMismatch(run);
+		mismatches += mismatch;
+		exceeded += familyExceeded(run);
+		printf("%s\t%d\t%s\t%d\t%d\t%d\t%d\t%s\t%.7f\t%lld%s\n", familyStrings[run.family], run.n,
+			caseStrings[run.caseType], run.letters, run.clauses, run.expected, (int)run.model.lo.size(),
+			outcomeStrings[run.model.outcome], run.time, run.stats.saturations, mismatch ? "\tUNEXPECTED" : "");
+	}
+	printf("# %d checks, %d with an unexpected size, %d over the limits\n", (int)runs.size(), mismatches, exceeded);
+	return mismatches > 0 || exceeded > 0;
+}
@@ -158,3 +158,21 @@ InputClauses randomInput2 (int n_clauses, int letters) {
 
 	return phi;
 }
+
+// the instance is generated from its own seed, independently of the order the
+// instances are generated in and of the thread generating it
+InputClauses seededInput(unsigned seed, int letters, int clauses, long long index) {
+	std::lock_guard<std::mutex> lock(generate_mutex);
+	std::seed_seq seq{ seed, (unsigned)letters, (unsigned)clauses, (unsigned)index };
+	rng.seed(seq);
+	return randomInput2(clauses, letters);
+}
+
+// the same with clauses of a fixed length, as randomInput() makes them
+InputClauses seededInput(unsigned seed, int letters, int clauses, int clauseLen, int maxFalseClauses, long long index) {
+	std::lock_guard<std::mutex> lock(generate_mutex);
+	std::seed_seq seq{ seed, (unsigned)letters, (unsigned)clauses, (unsigned)index,
+		(unsigned)clauseLen, (unsigned)maxFalseClauses };
+	rng.seed(seq);
+	return randomInput(clauses, letters, clauseLen, maxFalseClauses);
+}
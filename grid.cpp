@@ -0,0 +1,170 @@
+
+#include "horn.hpp"
+
+// The grid runs every cell of a spec in this process, on one pool shared by
+// all the cells, so that a sweep costs the time of its checks instead of a
+// process start per cell. The instances of a cell are generated from the seed
+// and the cell, so every case of a grid checks the same inputs.
+
+struct GridCell {
+	Case caseType;
+	int letters;
+	int clauses;
+	int clauseLen;
+	std::vector<Outcome> outcomes;
+	std::vector<double> times;
+
+	int count(Outcome outcome) const {
+		return std::count(outcomes.begin(), outcomes.end(), outcome);
+	}
+};
+
+bool parseGridInts(const std::string& value, std::vector<int>& out) {
+	out.clear();
+	std::stringstream items(value);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		int from, to;
+		char dash;
+		std::stringstream range(item);
+		if (!(range >> from)) return false;
+		to = from;
+		if (range >> dash && (dash != '-' || !(range >> to))) return false;
+		if (from < 0 || to < from) return false;
+		for (int i = from; i <= to; i++) out.push_back(i);
+	}
+	return !out.empty();
+}
+
+// the letters and clauses of an input, unlike the clause lengths where 0 is variable
+bool parseGridCounts(const std::string& value, std::vector<int>& out) {
+	return parseGridInts(value, out) && std::all_of(out.begin(), out.end(), [](int n) { return n >= 1; });
+}
+
+bool parseGridCases(std::string value, std::vector<Case>& out) {
+	out.clear();
+	for (auto &c : value) {
+		c = (char)toupper(c);
+	}
+	std::stringstream items(value);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		Case caseType = parseCaseType(item);
+		if (caseType == INVALID_CASE) return false;
+		if (caseType == ALL_CASES) {
+			out.insert(out.end(), { FINITE, NATURAL, DISCRETE });
+		} else {
+			out.push_back(caseType);
+		}
+	}
+	return !out.empty();
+}
+
+bool parseGridSpec(const std::string& text, GridSpec& spec, std::string& error) {
+	spec = GridSpec();
+	spec.cases = { FINITE };
+	spec.letters = { 3 };
+	spec.clauses = { 4 };
+	spec.clauseLens = { 0 };
+
+	std::stringstream lines(text);
+	std::string line;
+	while (std::getline(lines, line)) {
+		line = line.substr(0, line.find('#'));
+		std::stringstream tokens(line);
+		std::string token;
+		while (tokens >> token) {
+			auto eq = token.find('=');
+			std::string key = token.substr(0, eq);
+			std::string value = eq == std::string::npos ? "" : token.substr(eq + 1);
+
+			bool valid;
+			if (key == "case") valid = parseGridCases(value, spec.cases);
+			else if (key == "letters") valid = parseGridCounts(value, spec.letters);
+			else if (key == "clauses") valid = parseGridCounts(value, spec.clauses);
+			else if (key == "clause_len") valid = parseGridInts(value, spec.clauseLens);
+			else if (key == "samples") valid = sscanf(value.c_str(), "%d", &spec.samples) == 1 && spec.samples > 0;
+			else if (key == "max_false_clauses") valid = sscanf(value.c_str(), "%d", &spec.maxFalseClauses) == 1;
+			else {
+				error = "unknown key " + key + ", use: case, letters, clauses, clause_len, samples, max_false_clauses";
+				return false;
+			}
+			if (!valid) {
+				error = "invalid value for " + key + ": " + value;
+				if (key == "letters" || key == "clauses") error += ", pass integers of at least 1 like 1,2,5-9";
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void gridCheck(const GridOptions& options, GridCell& cell, int sample, std::mutex& cellsMutex) {
+	using namespace std::chrono;
+
+	auto phi = cell.clauseLen > 0 ?
+		seededInput(options.seed, cell.letters, cell.clauses, cell.clauseLen, options.spec.maxFalseClauses, sample) :
+		seededInput(options.seed, cell.letters, cell.clauses, sample);
+
+	auto t1 = high_resolution_clock::now();
+	Model model = check(phi, cell.caseType, nullptr, options.limits);
+	auto t2 = high_resolution_clock::now();
+
+	std::lock_guard<std::mutex> lock(cellsMutex);
+	cell.outcomes.push_back(model.outcome);
+	cell.times.push_back((duration_cast<duration<double>>(t2 - t1)).count());
+}
+
+int runGrid(const GridOptions& options) {
+	using namespace std::chrono;
+	auto& spec = options.spec;
+
+	std::vector<GridCell> cells;
+	for (auto caseType : spec.cases) {
+		for (auto letters : spec.letters) {
+			for (auto clauses : spec.clauses) {
+				for (auto clauseLen : spec.clauseLens) {
+					cells.push_back({ caseType, letters, clauses, clauseLen, {}, {} });
+				}
+			}
+		}
+	}
+
+	printf("# grid of %d cells, %d samples each, seed %u\n", (int)cells.size(), spec.samples, options.seed);
+
+	auto t1 = high_resolution_clock::now();
+	{
+		std::mutex cellsMutex;
+		TaskPool pool(options.threads, 2 * options.threads);
+		// the samples go round the cells, so the slow cells don't all come last
+		for (int sample = 0; sample < spec.samples; sample++) {
+			for (auto &cell : cells) {
+				// randomInput() needs as many distinct literals as the clause length
+				if (cell.clauseLen > 3 * cell.letters) continue;
+				GridCell *target = &cell;
+				pool.submit([&options, target, sample, &cellsMutex] { gridCheck(options, *target, sample, cellsMutex); });
+			}
+		}
+		pool.wait();
+	}
+	auto t2 = high_resolution_clock::now();
+
+	printf("%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n", "CASE", "NUM_LETTERS", "NUM_CLAUSES", "CLAUSE_LEN",
+		"SAMPLES", "SATISFIED", "UNSATISFIED", "OVER_LIMIT", "MEDIAN(s)", "MAX(s)", "TOTAL(s)");
+	double solves = 0;
+	for (auto &cell : cells) {
+		double total = 0, max = 0;
+		for (auto t : cell.times) {
+			total += t;
+			max = std::max(max, t);
+		}
+		solves += total;
+		printf("%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%.7f\t%.7f\t%.7f\n", caseStrings[cell.caseType],
+			cell.letters, cell.clauses, cell.clauseLen, (int)cell.outcomes.size(),
+			cell.count(SATISFIED), cell.count(UNSATISFIED), cell.count(TIMEOUT) + cell.count(MEMOUT),
+			median(cell.times), max, total);
+	}
+	printf("# checks %.7fs, wall clock %.7fs on %d threads\n", solves,
+		(duration_cast<duration<double>>(t2 - t1)).count(), options.threads);
+	return 0;
+}
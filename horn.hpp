@@ -3,11 +3,13 @@
 #include <random>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <streambuf>
 #include <string>
 #include <cstring>
 #include <cctype>
 #include <cstdlib>
+#include <cmath>
 #include <ctime>
 #include <vector>
 #include <queue>
@@ -18,6 +20,23 @@
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <atomic>
+#include <map>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+#include <fcntl.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 enum FormulaType {
 	LETTER,
@@ -43,6 +62,50 @@ const char *caseStrings[] = {
 	"INVALID",
 };
 
+// a check that runs out of its budget has no answer
+enum Outcome {
+	UNSATISFIED,
+	SATISFIED,
+	TIMEOUT,
+	MEMOUT,
+};
+
+const char *outcomeStrings[] = {
+	"NO",
+	"YES",
+	"TIMEOUT",
+	"MEMOUT",
+};
+
+enum ExportFormat {
+	EXPORT_TEXT,
+	EXPORT_JSON,
+	EXPORT_DOT,
+	INVALID_EXPORT,
+};
+
+const char *exportFormatStrings[] = {
+	"text",
+	"json",
+	"dot",
+	"invalid",
+};
+
+// the order check() tries the start intervals of every size in
+enum CandidateOrder {
+	ORDER_LEX,   // by x, then by y
+	ORDER_ENDS,  // closest to the two ends of the model first
+	ORDER_LAST,  // the start of the last model found by this thread first
+	INVALID_ORDER,
+};
+
+const char *candidateOrderStrings[] = {
+	"lex",
+	"ends",
+	"last",
+	"invalid",
+};
+
 
 #define FALSEHOOD 0
 #define TRUTH 1
@@ -65,11 +128,125 @@ struct InputClauses {
 	std::vector<std::string> labels;
 };
 
+// counters collected during a single check, only when the caller asks for them
+struct Stats {
+	long long sizes;          // model sizes tried by check()
+	long long saturations;    // calls to saturate(), one per candidate start interval
+	long long passes;         // saturation passes over the interval matrix
+	long long extends;        // calls to extend()
+	long long labelInserts;   // new labels added to lo
+	long long clauseFirings;  // rules whose body was satisfied in some interval
+	long long pendingPushes;  // formulas pushed to hi
+	long long refutations;    // checks decided by refute() before the size loop
+	double setupTime;         // seconds spent preparing the state in check()
+	double initTime;          // seconds spent allocating and seeding hi and lo
+	double saturateTime;      // seconds spent in the saturation passes
+	double extendTime;        // seconds spent in extend()
+	int decidingSize;         // size of the model found, or the last size tried
+
+	Stats& operator+=(const Stats& other);
+};
+
+// limits of a single check, zero means unlimited
+struct Limits {
+	double time;        // seconds of wall-clock time
+	long long passes;   // saturation passes, summed over all the candidates
+	double memory;      // megabytes held by hi and lo in a single saturation
+};
+
+// the resources used by a check, tested cooperatively by the size loop and
+// after every saturation pass; the memory is an estimate from the number of
+// intervals, labels and pending formulas since the sets don't report it
+struct Budget {
+	Limits limits;
+	std::chrono::steady_clock::time_point deadline;
+	long long passes;
+	size_t bytes;
+
+	Budget(const Limits& limits) : limits(limits), passes(0), bytes(0) {
+		auto duration = std::chrono::duration<double>(limits.time);
+		deadline = std::chrono::steady_clock::now() +
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+	}
+
+	static bool enabled(const Limits& limits) {
+		return limits.time > 0 || limits.passes > 0 || limits.memory > 0;
+	}
+
+	bool exceeded(Outcome& outcome) const {
+		outcome = MEMOUT;
+		if (limits.memory > 0 && bytes > limits.memory * 1024 * 1024) return true;
+		outcome = TIMEOUT;
+		if (limits.passes > 0 && passes > limits.passes) return true;
+		if (limits.time > 0 && std::chrono::steady_clock::now() > deadline) return true;
+		return false;
+	}
+};
+
+struct ModelExporter;
+struct TraceRing;
+struct RuleSeed;
+
+// the rules of a check compiled to flat arrays of literal indices by
+// compileRules(), once per check and shared by all its saturations
+struct RuleProgram {
+	// what a pending literal does when it reaches lo
+	enum Action : uint8_t {
+		DROP,           // T, which is everywhere already
+		CONFLICT,       // F
+		LABEL,          // the other letters
+		SPREAD_ROW,     // [A]p, also puts p in the row of the end point
+		SPREAD_COLUMN,  // [P]p, also puts p in the column of the start point
+	};
+
+	std::vector<int> bodyStart;    // the body of the rule r is body[bodyStart[r], bodyStart[r + 1])
+	std::vector<int> body;
+	std::vector<int> heads;        // the literal of the head of every rule
+	std::vector<uint8_t> actions;  // of every literal
+	std::vector<int> targets;      // of every literal, the letter put by SPREAD_ROW and SPREAD_COLUMN
+	std::vector<std::pair<int, int>> boxa, boxaBar;  // the [A]p and [P]p of the input, and p
+	std::vector<int> slots;        // of every literal, its matrix in the bits of saturate(), -1 if it can't be a label
+	int indexed;                   // the literals with a matrix
+	int words;                     // of a label set in saturateSmall(), 0 to use saturate()
+	std::vector<uint64_t> bodyMasks;  // the bodies as words words each
+
+	int rules() const { return heads.size(); }
+	const int *bodyBegin(int r) const { return body.data() + bodyStart[r]; }
+	const int *bodyEnd(int r) const { return body.data() + bodyStart[r + 1]; }
+};
+
 struct State {
 	Case caseType;
 	InputClauses& phi;
 	std::vector<Formula> boxa;
 	std::vector<Formula> boxaBar;
+	Stats *stats;
+	Budget *budget;
+	ModelExporter *exporter;  // gets the labels added by every pass
+	TraceRing *trace;         // records the derivation, only with --trace
+	RuleProgram program;
+	const RuleSeed *seed;     // the rules alone at the size being checked, only in a batch
+};
+
+#define STAT_ADD(state, field, n) do { if ((state).stats) (state).stats->field += (n); } while (0)
+#define TRACE(state, event, f, z, t) do { if ((state).trace) (state).trace->record((event), (f), (z), (t)); } while (0)
+
+// adds the time spent until stop() or the end of the scope to a stats field,
+// the clock isn't read at all when there is no field to update
+struct PhaseTimer {
+	double *field;
+	std::chrono::high_resolution_clock::time_point start;
+
+	PhaseTimer(double *field) : field(field) {
+		if (field) start = std::chrono::high_resolution_clock::now();
+	}
+	~PhaseTimer() { stop(); }
+	void stop() {
+		if (!field) return;
+		auto end = std::chrono::high_resolution_clock::now();
+		*field += std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+		field = nullptr;
+	}
 };
 
 inline bool operator==(const Formula& lhs, const Formula& rhs) {
@@ -90,6 +267,12 @@ struct FormulaHash {
 
 typedef std::unordered_set<Formula, FormulaHash> FormulaSet;
 typedef std::vector<Formula> FormulaVector;
+
+// rough sizes of the containers in a saturation, used for the memory budget
+const size_t intervalBytes = sizeof(FormulaVector) + sizeof(FormulaSet);
+const size_t labelBytes = sizeof(Formula) + 2 * sizeof(void*);
+const size_t pendingBytes = sizeof(Formula);
+
 // since the array isn't ordered we can swap elements and delete in constant time
 inline void eraseFast(FormulaVector& v, int i) {
 	int last = v.size() - 1;
@@ -102,52 +285,790 @@ template<typename T> struct IntervalVector {
 	private:
 		size_t n;
 		std::vector<T> v;
-		int getIndex(int x, int y) {
+		int getIndex(int x, int y) const {
 			x = (n - x) - 2;
 			y = (n - y) - 1;
 			return (x * (x + 1) / 2) + y;
 		}
 
+		// the intervals of a row are next to each other in v, the later
+		// end points first
+		template <typename Self, typename F>
+		static void walk(Self& self, int x, int from, int to, F f) {
+			if (from >= to) return;
+			int index = self.getIndex(x, from);
+			for (int y = from; y < to; y++, index--) f(y, self.v[index]);
+		}
+
 	public:
 		IntervalVector() : n(0), v() {}
 		IntervalVector(size_t size) : n(size), v(size * (size + 1) /2) {}
 		T& get(int x, int y) {
 			return v[getIndex(x, y)];
 		}
-		size_t size() {
+		const T& get(int x, int y) const {
+			return v[getIndex(x, y)];
+		}
+		size_t size() const {
 			return n;
 		}
+
+		// f(y, get(x, y)) for the intervals [x, y] with y in [from, to)
+		template <typename F> void forEachInRow(int x, int from, int to, F f) { walk(*this, x, from, to, f); }
+		template <typename F> void forEachInRow(int x, int from, int to, F f) const { walk(*this, x, from, to, f); }
+};
+
+// formulas other than clauses as dense indices, three for each label
+inline int literalIndex(Formula f) {
+	return f.id * 3 + f.type;
+}
+
+inline Formula literalFormula(int index) {
+	return Formula::create((FormulaType)(index % 3), index / 3);
+}
+
+// index of the lowest set bit, the word must not be zero
+inline int lowestBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_IX86)
+	// the 64 bit intrinsics are x64 only, a 32 bit build scans the halves
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)word)) return (int)index;
+	_BitScanForward(&index, (unsigned long)(word >> 32));
+	return (int)index + 32;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+inline int bitCount(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_IX86)
+	return (int)(__popcnt((unsigned int)word) + __popcnt((unsigned int)(word >> 32)));
+#elif defined(_MSC_VER)
+	return (int)__popcnt64(word);
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+// the bits in [from, to) of the word that holds bit i
+inline uint64_t wordMask(int i, int from, int to) {
+	int base = i & ~63;
+	int lo = std::max(from - base, 0);
+	int hi = std::min(to - base, 64);
+	if (lo >= hi) return 0;
+	uint64_t mask = (hi == 64) ? ~0ULL : ((1ULL << hi) - 1);
+	return mask & ~((1ULL << lo) - 1);
+}
+
+// a triangular matrix with one bit for every interval [z, t] of a model of
+// size d, for each of n formulas; the bits are kept both row-major (bit t of
+// row z) and column-major (bit z of column t) so that whole rows and columns
+// can be filled and tested a word at a time. That is 2 * d * ceil(d / 64)
+// words a formula, so the formulas that can never be set may be left out:
+// slots gives the matrix of every formula, -1 for the ones left out, and
+// only those with a matrix can be read or set
+struct TriangularBits {
+	int n, d, words;
+	std::vector<int> slots;
+	std::vector<uint64_t> rowBits, colBits;
+
+	TriangularBits() : n(0), d(0), words(0) {}
+	TriangularBits(int n, int d) : n(n), d(d), words((d + 63) / 64), slots(n),
+		rowBits((size_t)n * d * words), colBits((size_t)n * d * words) {
+		for (int f = 0; f < n; f++) slots[f] = f;
+	}
+	TriangularBits(const std::vector<int>& slots, int indexed, int d) : n(slots.size()), d(d), words((d + 63) / 64),
+		slots(slots), rowBits((size_t)indexed * d * words), colBits((size_t)indexed * d * words) {}
+
+	bool indexed(int f) const { return slots[f] >= 0; }
+	uint64_t *row(int f, int z) { return &rowBits[((size_t)slots[f] * d + z) * words]; }
+	uint64_t *col(int f, int t) { return &colBits[((size_t)slots[f] * d + t) * words]; }
+	const uint64_t *row(int f, int z) const { return &rowBits[((size_t)slots[f] * d + z) * words]; }
+	const uint64_t *col(int f, int t) const { return &colBits[((size_t)slots[f] * d + t) * words]; }
+
+	bool test(int f, int z, int t) const {
+		return (row(f, z)[t >> 6] >> (t & 63)) & 1;
+	}
+	bool set(int f, int z, int t) {
+		uint64_t bit = 1ULL << (t & 63);
+		uint64_t &word = row(f, z)[t >> 6];
+		if (word & bit) return false;
+		word |= bit;
+		col(f, t)[z >> 6] |= 1ULL << (z & 63);
+		return true;
+	}
+
+	// calls f(i) for every bit in [from, to) that isn't set, f can set the bits
+	template<typename F> static void forEachClear(const uint64_t *bits, int from, int to, F f) {
+		for (int w = from >> 6; w < ((to + 63) >> 6); w++) {
+			for (uint64_t clear = wordMask(w << 6, from, to) & ~bits[w]; clear; clear &= clear - 1) {
+				f((w << 6) + lowestBit(clear));
+			}
+		}
+	}
+
+	// calls f(i) for every bit in [from, to) set in src but not in dst, f can
+	// set the bits of dst
+	template<typename F> static void forEachNew(const uint64_t *src, const uint64_t *dst, int from, int to, F f) {
+		for (int w = from >> 6; w < ((to + 63) >> 6); w++) {
+			for (uint64_t added = wordMask(w << 6, from, to) & src[w] & ~dst[w]; added; added &= added - 1) {
+				f((w << 6) + lowestBit(added));
+			}
+		}
+	}
+
+	// true if all the bits in [from, to) are set
+	static bool full(const uint64_t *bits, int from, int to) {
+		for (int w = from >> 6; w < ((to + 63) >> 6); w++) {
+			uint64_t mask = wordMask(w << 6, from, to);
+			if ((bits[w] & mask) != mask) return false;
+		}
+		return true;
+	}
+};
+
+// out gets the AND of the k rows without the bits of mask, over n words;
+// returns true if any bit is left
+inline bool andRows(const uint64_t *const *rows, int k, const uint64_t *mask, uint64_t *out, size_t n) {
+	size_t i = 0;
+	uint64_t any = 0;
+#if defined(__AVX2__)
+	__m256i acc = _mm256_setzero_si256();
+	for (; i + 4 <= n; i += 4) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(rows[0] + i));
+		for (int j = 1; j < k; j++) {
+			v = _mm256_and_si256(v, _mm256_loadu_si256((const __m256i*)(rows[j] + i)));
+		}
+		v = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i*)(mask + i)), v);
+		_mm256_storeu_si256((__m256i*)(out + i), v);
+		acc = _mm256_or_si256(acc, v);
+	}
+	any = !_mm256_testz_si256(acc, acc);
+#elif defined(__SSE2__) || defined(_M_X64)
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 2 <= n; i += 2) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(rows[0] + i));
+		for (int j = 1; j < k; j++) {
+			v = _mm_and_si128(v, _mm_loadu_si128((const __m128i*)(rows[j] + i)));
+		}
+		v = _mm_andnot_si128(_mm_loadu_si128((const __m128i*)(mask + i)), v);
+		_mm_storeu_si128((__m128i*)(out + i), v);
+		acc = _mm_or_si128(acc, v);
+	}
+	uint64_t parts[2];
+	_mm_storeu_si128((__m128i*)parts, acc);
+	any = parts[0] | parts[1];
+#endif
+	for (; i < n; i++) {
+		uint64_t word = rows[0][i];
+		for (int j = 1; j < k; j++) {
+			word &= rows[j][i];
+		}
+		out[i] = word & ~mask[i];
+		any |= out[i];
+	}
+	return any != 0;
+}
+
+// the labels of one interval, kept as the literal indices in whichever form is
+// smallest for how many there are: a sorted array while there are few, a hash
+// set past sortedLabels, and a bitset over the literals up to the largest one
+// from denseLabels on, while it takes no more room than the array would; a
+// high literal that would grow the bitset past that turns it back into an
+// array or a hash set, so an interval of a large alphabet with a few labels
+// stays small
+struct LabelSet {
+	static const size_t sortedLabels = 32;
+	static const size_t denseLabels = 8;
+
+	LabelSet() : kind(SORTED), labels(0), top(0) {}
+	LabelSet(const LabelSet& other) { *this = other; }
+	LabelSet(LabelSet&&) = default;
+	LabelSet& operator=(LabelSet&&) = default;
+	LabelSet& operator=(const LabelSet& other) {
+		kind = other.kind;
+		labels = other.labels;
+		top = other.top;
+		data = other.data;
+		hashed.reset(other.hashed ? new std::unordered_set<int>(*other.hashed) : nullptr);
+		return *this;
+	}
+
+	bool insert(Formula f) { return insert(literalIndex(f)); }
+	bool insert(int l) {
+		switch (kind) {
+			case SORTED: {
+				auto it = std::lower_bound(data.begin(), data.end(), (uint32_t)l);
+				if (it != data.end() && *it == (uint32_t)l) return false;
+				data.insert(it, l);
+				break;
+			}
+			case HASHED:
+				if (!hashed->insert(l).second) return false;
+				break;
+			case DENSE: {
+				if ((size_t)(l >> 5) >= data.size()) {
+					if (!dense(labels + 1, l)) {
+						top = std::max(top, l);
+						sparsen();
+						return insert(l);
+					}
+					data.resize((l >> 5) + 1);
+				}
+				uint32_t bit = 1U << (l & 31);
+				if (data[l >> 5] & bit) return false;
+				data[l >> 5] |= bit;
+				break;
+			}
+		}
+		labels++;
+		top = std::max(top, l);
+		if (kind != DENSE) adapt();
+		return true;
+	}
+
+	// the labels of other are added whatever the forms of the two sets
+	void merge(const LabelSet& other) {
+		for (auto f : other) insert(f);
+	}
+
+	size_t count(Formula f) const {
+		int l = literalIndex(f);
+		switch (kind) {
+			case SORTED: return std::binary_search(data.begin(), data.end(), (uint32_t)l);
+			case HASHED: return hashed->count(l);
+			default: return (size_t)(l >> 5) < data.size() && ((data[l >> 5] >> (l & 31)) & 1);
+		}
+	}
+	size_t size() const { return labels; }
+	bool empty() const { return labels == 0; }
+
+	struct const_iterator {
+		const LabelSet *set;
+		size_t pos;  // in the sorted array, or the literal in the bitset
+		std::unordered_set<int>::const_iterator it;
+
+		Formula operator*() const {
+			switch (set->kind) {
+				case SORTED: return literalFormula(set->data[pos]);
+				case HASHED: return literalFormula(*it);
+				default: return literalFormula(pos);
+			}
+		}
+		const_iterator& operator++() {
+			if (set->kind == HASHED) ++it;
+			else if (set->kind == SORTED) pos++;
+			else pos = set->nextDense(pos + 1);
+			return *this;
+		}
+		bool operator==(const const_iterator& other) const {
+			return set->kind == HASHED ? it == other.it : pos == other.pos;
+		}
+		bool operator!=(const const_iterator& other) const { return !(*this == other); }
+	};
+
+	const_iterator begin() const {
+		switch (kind) {
+			case SORTED: return { this, 0, {} };
+			case HASHED: return { this, 0, hashed->begin() };
+			default: return { this, nextDense(0), {} };
+		}
+	}
+	const_iterator end() const {
+		switch (kind) {
+			case SORTED: return { this, data.size(), {} };
+			case HASHED: return { this, 0, hashed->end() };
+			default: return { this, data.size() * 32, {} };
+		}
+	}
+
+	private:
+		enum Kind : uint8_t { SORTED, HASHED, DENSE };
+		Kind kind;
+		size_t labels;
+		int top;
+		std::vector<uint32_t> data;  // the sorted literals, or the words of the bitset
+		std::unique_ptr<std::unordered_set<int>> hashed;
+
+		// no more words in the bitset than labels
+		static bool dense(size_t labels, int top) {
+			return labels >= denseLabels && (size_t)(top >> 5) < labels;
+		}
+
+		void adapt() {
+			if (dense(labels, top)) {
+				std::vector<uint32_t> words((top >> 5) + 1);
+				for (auto f : *this) {
+					int l = literalIndex(f);
+					words[l >> 5] |= 1U << (l & 31);
+				}
+				data.swap(words);
+				hashed.reset();
+				kind = DENSE;
+			} else if (kind == SORTED && labels > sortedLabels) {
+				hashed.reset(new std::unordered_set<int>(data.begin(), data.end()));
+				data.clear();
+				data.shrink_to_fit();
+				kind = HASHED;
+			}
+		}
+
+		void sparsen() {
+			std::vector<uint32_t> sorted;
+			sorted.reserve(labels + 1);
+			for (auto f : *this) sorted.push_back(literalIndex(f));
+			data.swap(sorted);
+			kind = SORTED;
+			adapt();
+		}
+
+		size_t nextDense(size_t l) const {
+			for (size_t w = l >> 5; w < data.size(); w++) {
+				uint32_t word = data[w] & (~0U << (w == (l >> 5) ? (l & 31) : 0));
+				if (word) return w * 32 + lowestBit(word);
+			}
+			return data.size() * 32;
+		}
 };
 
 struct Model {
-	Model(IntervalVector<FormulaSet> lo, bool satisfied, Interval start)
-		: lo(lo), satisfied(satisfied), start(start) {}
-	static Model unsatisfied() { return Model({}, false, {}); }
-	IntervalVector<FormulaSet> lo;
+	Model(IntervalVector<LabelSet> lo, bool satisfied, Interval start)
+		: lo(std::move(lo)), satisfied(satisfied), outcome(satisfied ? SATISFIED : UNSATISFIED), start(start) {}
+	// the reference engine keeps its labels in hash sets
+	Model(const IntervalVector<FormulaSet>& labels, bool satisfied, Interval start)
+		: Model(IntervalVector<LabelSet>(labels.size()), satisfied, start) {
+		int d = labels.size();
+		for (int z = 0; z < d - 1; z++) {
+			labels.forEachInRow(z, z + 1, d, [&](int t, const FormulaSet& set) {
+				for (auto f : set) lo.get(z, t).insert(f);
+			});
+		}
+	}
+	static Model unsatisfied() { return Model(IntervalVector<LabelSet>(), false, Interval()); }
+	static Model exceeded(Outcome outcome) {
+		Model model = unsatisfied();
+		model.outcome = outcome;
+		return model;
+	}
+	IntervalVector<LabelSet> lo;
 	bool satisfied = false;
+	Outcome outcome = UNSATISFIED;
 	Interval start;
 };
 
+/* Shared State */
+extern std::mutex stdout_mutex;
+extern std::mutex generate_mutex;
+extern std::mt19937 rng;
+extern CandidateOrder candidate_order;
+extern bool prune_symmetric;
+extern bool print_messages;
+extern bool small_engine;
+extern bool refute_filter;
+
+/* Task Pool */
+// runs independent tasks on a fixed set of threads; every worker takes the
+// newest tasks of its own queue first and steals the oldest ones of the
+// others when it runs out, submit() blocks while capacity tasks are waiting
+// so that a producer can't run ahead of the workers
+struct TaskPool {
+	typedef std::function<void()> Task;
+
+	TaskPool(int threads, size_t capacity);
+	~TaskPool();
+
+	void submit(Task task);
+	// returns when every task submitted so far has finished
+	void wait();
+
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake, space, idle;
+		size_t capacity;
+		size_t waiting;     // submitted and not started
+		size_t ready;       // in a queue and not claimed by a worker
+		size_t unfinished;  // submitted and not finished
+		bool stopping;
+		std::atomic<size_t> nextQueue;
+
+		bool take(int id, Task &task);
+		void worker(int id);
+};
+
 /* Satisfiability Checker */
-Model check(InputClauses& phi, Case caseType);
+Model check(InputClauses& phi, Case caseType, Stats *stats = nullptr, const Limits& limits = Limits());
+// the sizes of the models check() tries, false for an invalid case
+bool checkSizes(Case caseType, size_t rules, int& min, int& max);
 Model saturate(int d, int x, int y, const State& phi);
-int extend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<FormulaSet>& lo, const State& phi);
+template <int W> Model saturateSmall(int d, int x, int y, const State& state);
+// saturateSmall() when the literals of the instance fit, saturate() otherwise
+Model saturateAny(int d, int x, int y, const State& state);
+int smallWords(const InputClauses& phi);
+// the [A] and [P] literals of the input and the compiled rules
+void prepareState(State& state);
+void compileRules(State& state, int words);
+void compileBoxes(State& state);
+void indexLiterals(State& state);
+int saturationWorkers(int d, const State& state);
+// true if the facts and the rules alone derive a conflict in the start interval
+bool refute(const State& state);
+void startCandidates(int k, const State& state, std::vector<Interval>& candidates);
+CandidateOrder parseCandidateOrder(const std::string& name);
+int extend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<LabelSet>& lo, TriangularBits& bits, const State& phi);
+
+/* Model Verifier */
+// returns a description of the first violated condition, or an empty string if
+// the model is valid for the case
+std::string verifyModel(const InputClauses& phi, Case caseType, const Model& model, int threads = 1);
+
+/* Unsatisfiable Core */
+struct CoreOptions {
+	Case caseType;      // ALL_CASES extracts a core for every case
+	int threads;
+	Limits limits;
+};
+
+int runUnsatCore(InputClauses& phi, const CoreOptions& options);
+
+/* Model Export */
+// output kept in memory and written to a file descriptor in large blocks
+struct OutputBuffer {
+	int fd;
+	std::vector<char> data;
+
+	OutputBuffer(int fd, size_t capacity = 1 << 16) : fd(fd) { data.reserve(capacity); }
+	~OutputBuffer() { flush(); }
+
+	void put(const char *s, size_t len) {
+		if (data.size() + len > data.capacity()) flush();
+		data.insert(data.end(), s, s + len);
+	}
+	void put(const char *s) { put(s, strlen(s)); }
+	void put(const std::string &s) { put(s.data(), s.size()); }
+	void put(char c) { put(&c, 1); }
+	void put(int n) {
+		char buf[16];
+		put(buf, snprintf(buf, sizeof(buf), "%d", n));
+	}
+	void flush();
+};
+
+// writes the labels of a model in one of the export formats; every write only
+// covers the labels added since the previous one, so a model can be written
+// pass by pass as it grows without repeating itself
+struct ModelExporter {
+	ModelExporter(int fd, ExportFormat format, const InputClauses& phi) : out(fd), format(format), phi(phi) {}
+
+	void begin(Case caseType, int d, Interval start);
+	void write(const IntervalVector<LabelSet>& lo, int pass = -1);
+	void end();
+
+	private:
+		OutputBuffer out;
+		ExportFormat format;
+		const InputClauses& phi;
+		int d = 0;
+		Interval start;
+		IntervalVector<LabelSet> written;  // with passes, the labels of the passes so far
+		FormulaVector added;
+
+		void label(Formula f);
+		void interval(int z, int t, int pass);
+};
+
+ExportFormat parseExportFormat(const std::string& name);
+// the file descriptor to export to, "-" is the standard output
+int openExport(const std::string& path);
+void closeExport(int fd);
+void exportModel(InputClauses& phi, Case caseType, const Model& model, int fd, ExportFormat format, bool passes);
+
+/* Derivation Trace */
+enum TraceEvent {
+	TRACE_START,      // a saturation of size id starting at [z, t]
+	TRACE_INSERT,     // a label added to [z, t]
+	TRACE_FIRE,       // the rule id fired in [z, t]
+	TRACE_BROADCAST,  // [A]p or [P]p spread from [z, t], or from the point z if t < 0
+	TRACE_EXTEND,     // the end of the pass id, z is the result of extend()
+	TRACE_CONFLICT,   // F derived in [z, t]
+	INVALID_TRACE,
+};
+
+struct TraceRecord {
+	uint8_t event;
+	uint8_t type;
+	uint16_t unused;
+	int32_t id;
+	int32_t z, t;
+};
+
+// the last events of the checks run by one thread, overwritten in a circle so
+// that recording never allocates or takes a lock
+struct TraceRing {
+	std::vector<TraceRecord> records;
+	uint64_t next = 0;
+
+	TraceRing(size_t capacity) : records(capacity) {}
+
+	void record(TraceEvent event, Formula f, int z, int t) {
+		TraceRecord& r = records[next++ & (records.size() - 1)];
+		r.event = event;
+		r.type = f.type;
+		r.unused = 0;
+		r.id = f.id;
+		r.z = z;
+		r.t = t;
+	}
+	void clear() { next = 0; }
+};
+
+// the ring of the calling thread, or nullptr when tracing is off
+TraceRing *traceRing();
+// appends the events of the check to the trace file if it ran over its
+// limits, or after every check with --trace_all
+void traceCheck(const State& state, Outcome outcome);
+int decodeTrace(const std::string& path);
 
 /* Print Utilities */
 void printFormula(const InputClauses& phi, const Formula f, bool universal);
-void printInterval(const InputClauses& phi, const Interval& interval, const FormulaSet& formulas);
+void printInterval(const InputClauses& phi, const Interval& interval, const LabelSet& formulas);
 void printInterval(const InputClauses& phi, const Interval& interval, const FormulaVector& formulas);
-void printState(const InputClauses& phi, IntervalVector<FormulaSet> &intervals, int d);
+void printState(const InputClauses& phi, IntervalVector<LabelSet> &intervals, int d);
 void printState(const InputClauses& phi, IntervalVector<FormulaVector> &intervals, int d);
 
 void printFormula(FILE *stream, const InputClauses& phi, const Formula f, bool universal);
-void printInterval(FILE *stream, const InputClauses& phi, const Interval& interval, const FormulaSet& formulas);
+void printInterval(FILE *stream, const InputClauses& phi, const Interval& interval, const LabelSet& formulas);
 void printInterval(FILE *stream, const InputClauses& phi, const Interval& interval, const FormulaVector& formulas);
-void printState(FILE *stream, const InputClauses& phi, IntervalVector<FormulaSet> &intervals, int d);
+void printState(FILE *stream, const InputClauses& phi, IntervalVector<LabelSet> &intervals, int d);
 void printState(FILE *stream, const InputClauses& phi, IntervalVector<FormulaVector> &intervals, int d);
+void printStats(FILE *stream, const Stats& stats);
+void writeHorn(FILE *stream, const InputClauses& phi);
+
+/* Outlier Capture */
+// the bench times in buckets of a tenth of a decade from 100ns to 1000s, so
+// that a run of any length can ask for its percentiles in fixed memory
+struct TimeHistogram {
+	static const int buckets = 100;
+	long long counts[buckets] = {};
+	long long total = 0;
+
+	static int bucket(double time) {
+		if (time <= 0) return 0;
+		return std::min(std::max((int)std::floor((std::log10(time) + 7) * 10), 0), buckets - 1);
+	}
+	static double upperBound(int bucket) { return std::pow(10.0, (bucket + 1) / 10.0 - 7); }
+
+	void add(double time) {
+		counts[bucket(time)]++;
+		total++;
+	}
+	// the end of the bucket that holds the p-th percentile
+	double percentile(double p) const {
+		long long seen = 0;
+		for (int i = 0; i < buckets; i++) {
+			seen += counts[i];
+			if (seen * 100.0 >= p * total) return upperBound(i);
+		}
+		return upperBound(buckets - 1);
+	}
+};
+
+/* Benchmark Suite */
+// the slowdown over the baseline a cell can show before it counts as a
+// regression, when --tolerance doesn't set one
+const double suiteTolerance = 0.25;
+
+struct SuiteOptions {
+	unsigned seed;
+	int samples;
+	int warmup;
+	int repeats;
+	double tolerance;
+	std::string baselineFile;
+	std::string saveBaselineFile;
+};
+
+struct SuiteResult {
+	Case caseType;
+	int letters;
+	int clauses;
+	int samples;
+	int satisfied;
+	int invalid;
+	double median, spread;
+};
+
+int runBenchSuite(const SuiteOptions& options);
+
+/* Exhaustive Enumeration */
+struct EnumerateOptions {
+	Case caseType;
+	int letters;
+	int clauses;
+	int threads;
+	int top;
+};
+
+int runEnumeration(const EnumerateOptions& options);
+InputClauses enumerationTemplate(int letters, std::vector<Clause> &clauses);
+std::vector<std::vector<int>> clauseRenamings(std::vector<Clause> &clauses, int numLetters);
+bool isCanonical(const std::vector<int> &subset, const std::vector<std::vector<int>> &renamings);
+bool nextSubset(std::vector<int> &subset, int numClauses, size_t maxSize);
+InputClauses enumeratedInput(const InputClauses &inputTemplate, std::vector<Clause> &clauses, const std::vector<int> &rules);
+
+/* Phase Transition Sweep */
+struct SweepOptions {
+	Case caseType;
+	int maxLetters;
+	int maxClauses;
+	int samples;
+	int refine;
+	int threads;
+	unsigned seed;
+	Limits limits;
+};
+
+int runSweep(const SweepOptions& options);
+
+/* Differential Check */
+// the frozen reference engine, see reference.cpp
+Model referenceCheck(InputClauses& phi, Case caseType, const Limits& limits = Limits());
+
+struct DiffOptions {
+	Case caseType;      // ALL_CASES compares every case
+	int letters;
+	int clauses;
+	long long instances;
+	int threads;
+	bool enumerate;     // enumerated instead of generated inputs
+	unsigned seed;
+	Limits limits;
+	std::string inputFile;
+	std::string outputFile;
+};
+
+int runDiff(const DiffOptions& options);
+
+/* Benchmark Grid */
+// the cells are every combination of the axes, each with its own samples
+struct GridSpec {
+	std::vector<Case> cases;
+	std::vector<int> letters;
+	std::vector<int> clauses;
+	std::vector<int> clauseLens;  // 0 is the variable length of the bench generator
+	int samples = 10;
+	int maxFalseClauses = 1;
+};
+
+struct GridOptions {
+	GridSpec spec;
+	int threads;
+	unsigned seed;
+	Limits limits;
+};
+
+// the spec is a list of key=value, the axes take lists and ranges like 1,2,5-9
+bool parseGridSpec(const std::string& text, GridSpec& spec, std::string& error);
+int runGrid(const GridOptions& options);
+
+/* Structured Families */
+// inputs whose minimal model grows with a parameter, see family.cpp
+enum Family {
+	AFTER_FAMILY,
+	BEFORE_FAMILY,
+	NESTED_FAMILY,
+	SPLIT_FAMILY,
+	EDGE_SAT_FAMILY,
+	EDGE_UNSAT_FAMILY,
+	INVALID_FAMILY,
+};
+
+struct FamilyOptions {
+	std::vector<Family> families;
+	std::vector<Case> cases;
+	std::vector<int> params;
+	int threads;
+	Limits limits;
+	std::string writePrefix;  // every instance is also written to <prefix>-<family>-<n>.horn
+};
+
+// a list of family names, or all of them with "all"
+bool parseFamilies(const std::string& value, std::vector<Family>& out);
+InputClauses familyInput(Family family, int n);
+int familyExpectedSize(Family family, Case caseType, int n);
+int runFamilies(const FamilyOptions& options);
+
+/* Batched Queries */
+// one set of rules checked against many sets of facts, see batch.cpp
+
+// the saturation of the rules alone at one size, where every saturation of
+// the queries at that size starts
+struct RuleSeed {
+	bool conflict;                // the rules alone have no model of this size
+	IntervalVector<LabelSet> lo;
+	std::vector<uint64_t> masks;  // lo as the label sets of saturateSmall(), d * d of program.words words
+};
+
+struct RuleBatch {
+	InputClauses rules;  // no facts, and the letters of all the queries
+	Case caseType;
+	State state;         // of the rules alone, compiled once for every query
+	Limits limits;       // of every saturation of the rules alone
+	int min, max;
+	std::unique_ptr<std::once_flag[]> computed;
+	std::vector<std::unique_ptr<RuleSeed>> seeds;  // of the sizes min..max, computed when first needed
+	std::atomic<size_t> bytes;                     // estimated for the seeds kept, see seedBytes()
+
+	RuleBatch(const InputClauses& phi, Case caseType, const Limits& limits = Limits());
+	RuleBatch(const RuleBatch&) = delete;
+	RuleBatch& operator=(const RuleBatch&) = delete;
+
+	// the state of a query, phi being the rules with the facts of the query
+	void prepare(State& query) const;
+	// null if the rules alone went over the limits, or the seeds kept so far
+	// over the memory limit, the queries then start from T
+	const RuleSeed *seed(int d);
+	// the most the seeds can take, the memory limit or seedMemory without one
+	size_t seedBytes() const;
+};
+
+struct BatchResult {
+	Model model;
+	Stats stats;
+	double time;  // of the check of the query
+};
+
+struct BatchOptions {
+	Case caseType;
+	int threads;
+	Limits limits;
+	bool compare;  // every query is also checked alone, and the models compared
+};
+
+// the same model check() finds for phi, which has the rules of the batch
+Model check(InputClauses& phi, RuleBatch& batch, Stats *stats = nullptr, const Limits& limits = Limits());
+// the queries on threads threads, in the order of queries
+std::vector<BatchResult> checkBatch(RuleBatch& batch, const std::vector<FormulaVector>& queries, int threads, const Limits& limits = Limits());
+// one query per line, its facts separated by spaces; new letters are added to phi
+std::vector<FormulaVector> parseQueries(const char *path, InputClauses& phi);
+int runBatch(InputClauses& phi, const std::vector<FormulaVector>& queries, const BatchOptions& options);
 
 /* Parser\\Generator Utilities */
+Case parseCaseType(const std::string &caseName);
 std::string numToLabel(int n);
 InputClauses parseFile(const char* path);
 InputClauses randomInput(int n_clauses, int letters, int clause_len, int max_falsehood);
+InputClauses randomInput2(int n_clauses, int letters);
+InputClauses seededInput(unsigned seed, int letters, int clauses, long long index);
+InputClauses seededInput(unsigned seed, int letters, int clauses, int clauseLen, int maxFalseClauses, long long index);
 
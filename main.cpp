@@ -4,11 +4,51 @@
 
 #include "utils.cpp"
 #include "generate.cpp"
+#include "bench.cpp"
+#include "verify.cpp"
+#include "sweep.cpp"
+#include "reference.cpp"
+#include "diff.cpp"
+#include "export.cpp"
+#include "core.cpp"
+#include "pool.cpp"
+#include "trace.cpp"
+#include "grid.cpp"
+#include "family.cpp"
+#include "small.cpp"
+#include "refute.cpp"
+#include "program.cpp"
+#include "batch.cpp"
 
 std::mutex stdout_mutex;
 std::mutex generate_mutex;
 
 bool print_messages = false;
+bool print_stats = false;
+Limits check_limits = {};
+std::atomic<long long> outcome_counts[4];
+
+// the bench instances slower than outlier_time, or than the outlier_percentile
+// of the times so far, are written to <outlier_prefix>-<seed>-<instance>.horn
+std::mutex outlier_mutex;
+TimeHistogram bench_times;
+double outlier_time = 0;
+double outlier_percentile = 0;
+std::string outlier_prefix = "outlier";
+
+// the models of --export, written one at a time
+std::mutex export_mutex;
+int export_fd = -1;
+ExportFormat export_format = EXPORT_TEXT;
+bool export_passes = false;
+
+// the search over the start intervals, see startCandidates()
+CandidateOrder candidate_order = ORDER_LEX;
+bool prune_symmetric = true;
+thread_local Interval last_start(-1, -1);
+
+// the workers sharing the rows of a single saturation, see runPhase()
+int saturate_threads = 1;
 
 void fprint(FILE *stream, InputClauses &phi) {
 	fprintf(stream, "---- Rules ----\n");
@@ -43,6 +83,21 @@ void print(std::vector<std::vector<int>> v) {
 	}
 }
 
+void printVerifyError(InputClauses &phi, Case caseType, Model &model, const std::string &error) {
+	stdout_mutex.lock();
+	fprintf(stderr, "Invalid model in the %s case with size %d and starting interval [%d, %d]: %s\n",
+		caseStrings[caseType], (int)model.lo.size(), model.start.first, model.start.second, error.c_str());
+	fprint(stderr, phi);
+	stdout_mutex.unlock();
+}
+
+bool verifyModelAndLog(InputClauses &phi, Case caseType, Model &model, int threads) {
+	auto error = verifyModel(phi, caseType, model, threads);
+	if (error.empty()) return true;
+	printVerifyError(phi, caseType, model, error);
+	return false;
+}
+
 void allPossibleClauses(FormulaVector &symbols, int start, std::vector<Clause> &clauses, Clause &clause) {
 
 	if (clause.size() > 0) {
@@ -153,6 +208,234 @@ void buildSet(std::vector<std::vector<int>> &old, std::vector<std::vector<int>>
 	}
 }
 
+// same order as nextInput/skipInput, but on indices into the clause list and
+// with at most maxSize clauses per input
+bool nextSubset(std::vector<int> &subset, int numClauses, size_t maxSize) {
+	if (subset.size() < maxSize && subset.back() + 1 < numClauses) {
+		subset.push_back(subset.back() + 1);
+		return true;
+	}
+
+	while (subset.size() > 0) {
+		int next = subset.back() + 1;
+		subset.pop_back();
+		if (next < numClauses) {
+			subset.push_back(next);
+			return true;
+		}
+	}
+	return false;
+}
+
+// the symbols of a letter are stored as [P]l, [A]l, l, like in the generator
+std::vector<int> clauseKey(const Clause &clause) {
+	std::vector<int> key;
+	for (auto f : clause) {
+		if (f.id == FALSEHOOD) key.push_back(-1);
+		else key.push_back((f.id - 2) * 3 + (f.type == LETTER ? 2 : f.type == BOXA ? 1 : 0));
+	}
+	std::sort(key.begin(), key.end() - 1);
+	return key;
+}
+
+// for every renaming of the letters, the index of the clause each clause is mapped to;
+// the first letter is never renamed since it appears in the fact
+std::vector<std::vector<int>> clauseRenamings(std::vector<Clause> &clauses, int numLetters) {
+	std::map<std::vector<int>, int> index;
+	for (size_t i = 0; i < clauses.size(); i++) {
+		index[clauseKey(clauses[i])] = i;
+	}
+
+	std::vector<std::vector<int>> renamings;
+	std::vector<int> letters(numLetters);
+	for (int i = 0; i < numLetters; i++) letters[i] = i + 2;
+
+	while (std::next_permutation(letters.begin() + 1, letters.end())) {
+		std::vector<int> renaming(clauses.size());
+		for (size_t i = 0; i < clauses.size(); i++) {
+			Clause renamed = clauses[i];
+			for (auto &f : renamed) {
+				if (f.id != FALSEHOOD) f.id = letters[f.id - 2];
+			}
+			renaming[i] = index[clauseKey(renamed)];
+		}
+		renamings.push_back(renaming);
+	}
+
+	return renamings;
+}
+
+// an input is enumerated only if no renaming of its letters gives a
+// lexicographically smaller set of clauses, the order of the clauses is
+// already fixed since the inputs are enumerated as sorted sets
+bool isCanonical(const std::vector<int> &subset, const std::vector<std::vector<int>> &renamings) {
+	std::vector<int> renamed(subset.size());
+	for (auto &renaming : renamings) {
+		for (size_t i = 0; i < subset.size(); i++) {
+			renamed[i] = renaming[subset[i]];
+		}
+		std::sort(renamed.begin(), renamed.end());
+		if (renamed < subset) return false;
+	}
+	return true;
+}
+
+struct EnumeratedInput {
+	std::vector<int> rules;
+	Outcome outcome;
+	int size;
+	long long saturations;
+	double time;
+};
+
+bool harderInput(const EnumeratedInput &a, const EnumeratedInput &b) {
+	if (a.saturations != b.saturations) return a.saturations > b.saturations;
+	return a.time > b.time;
+}
+
+bool largerModel(const EnumeratedInput &a, const EnumeratedInput &b) {
+	if (a.size != b.size) return a.size > b.size;
+	return harderInput(a, b);
+}
+
+void keepTop(std::vector<EnumeratedInput> &top, const EnumeratedInput &input, size_t count,
+	bool (*better)(const EnumeratedInput&, const EnumeratedInput&)) {
+	top.push_back(input);
+	std::sort(top.begin(), top.end(), better);
+	if (top.size() > count) top.pop_back();
+}
+
+struct EnumerationResult {
+	long long enumerated = 0;
+	long long checked = 0;
+	long long satisfied = 0;
+	long long invalid = 0;
+	long long exceeded = 0;
+	std::vector<EnumeratedInput> hardest;
+	std::vector<EnumeratedInput> largest;
+};
+
+InputClauses enumeratedInput(const InputClauses &inputTemplate, std::vector<Clause> &clauses, const std::vector<int> &rules) {
+	InputClauses phi = inputTemplate;
+	for (auto i : rules) {
+		phi.rules.push_back(clauses[i]);
+	}
+	return phi;
+}
+
+// every worker takes the next first clause and enumerates all the inputs
+// starting with it, the first clauses with more inputs are handed out first
+void enumerationWorker(const EnumerateOptions &options, const InputClauses &inputTemplate,
+	std::vector<Clause> &clauses, const std::vector<std::vector<int>> &renamings,
+	std::atomic<int> &nextFirst, EnumerationResult &total, std::mutex &totalMutex) {
+	using namespace std::chrono;
+
+	EnumerationResult result;
+	int numClauses = clauses.size();
+	for (int first = nextFirst++; first < numClauses; first = nextFirst++) {
+		std::vector<int> subset = { first };
+		do {
+			result.enumerated++;
+			if (!isCanonical(subset, renamings)) continue;
+
+			InputClauses phi = enumeratedInput(inputTemplate, clauses, subset);
+			Stats stats = {};
+			auto t1 = high_resolution_clock::now();
+			Model model = check(phi, options.caseType, &stats, check_limits);
+			auto t2 = high_resolution_clock::now();
+
+			EnumeratedInput input = { subset, model.outcome, (int)model.lo.size(),
+				stats.saturations, (duration_cast<duration<double>>(t2 - t1)).count() };
+			result.checked++;
+			if (!verifyModelAndLog(phi, options.caseType, model, 1)) {
+				result.invalid++;
+			}
+			if (model.outcome == TIMEOUT || model.outcome == MEMOUT) {
+				result.exceeded++;
+			}
+			if (model.satisfied) {
+				result.satisfied++;
+				keepTop(result.largest, input, options.top, largerModel);
+			}
+			keepTop(result.hardest, input, options.top, harderInput);
+
+		} while (nextSubset(subset, numClauses, options.clauses) && subset[0] == first);
+	}
+
+	std::lock_guard<std::mutex> lock(totalMutex);
+	total.enumerated += result.enumerated;
+	total.checked += result.checked;
+	total.satisfied += result.satisfied;
+	total.invalid += result.invalid;
+	total.exceeded += result.exceeded;
+	for (auto &input : result.hardest) keepTop(total.hardest, input, options.top, harderInput);
+	for (auto &input : result.largest) keepTop(total.largest, input, options.top, largerModel);
+}
+
+void printEnumeratedInputs(const char *title, const std::vector<EnumeratedInput> &inputs,
+	const InputClauses &inputTemplate, std::vector<Clause> &clauses) {
+	printf("---- %s ----\n", title);
+	for (size_t i = 0; i < inputs.size(); i++) {
+		auto &input = inputs[i];
+		printf("#%d: %s, size %d, %lld saturations, %.7fs\n", (int)i + 1,
+			input.outcome == SATISFIED ? "SATISFIABLE" : input.outcome == UNSATISFIED ? "NOT SATISFIABLE" :
+			input.outcome == TIMEOUT ? "TIMEOUT" : "MEMOUT", input.size, input.saturations, input.time);
+		writeHorn(stdout, enumeratedInput(inputTemplate, clauses, input.rules));
+		printf("\n");
+	}
+}
+
+// the input every enumerated input is built on, with the fact on the first
+// letter, and the list of all the possible clauses over the letters
+InputClauses enumerationTemplate(int letters, std::vector<Clause> &clauses) {
+	InputClauses inputTemplate;
+	inputTemplate.labels.push_back("F");
+	inputTemplate.labels.push_back("T");
+
+	FormulaVector symbols;
+	for (int i = 0; i < letters; i++) {
+		inputTemplate.labels.push_back(numToLabel(i));
+		symbols.push_back(Formula::create(BOXA_BAR, i + 2));
+		symbols.push_back(Formula::create(BOXA, i + 2));
+		symbols.push_back(Formula::create(LETTER, i + 2));
+	}
+	inputTemplate.facts.push_back(Formula::create(LETTER, 2));
+
+	allPossibleClauses(symbols, 0, clauses);
+	return inputTemplate;
+}
+
+int runEnumeration(const EnumerateOptions &options) {
+	std::vector<Clause> clauses;
+	auto inputTemplate = enumerationTemplate(options.letters, clauses);
+	auto renamings = clauseRenamings(clauses, options.letters);
+
+	printf("Enumerating all the inputs with up to %d of the %d possible clauses over %d letters in the %s case\n",
+		options.clauses, (int)clauses.size(), options.letters, caseStrings[options.caseType]);
+
+	EnumerationResult total;
+	std::mutex totalMutex;
+	std::atomic<int> nextFirst(0);
+	std::vector<std::thread> threads;
+	for (int threadId = 0; threadId < options.threads; threadId++) {
+		threads.push_back(std::thread(enumerationWorker, std::cref(options), std::cref(inputTemplate),
+			std::ref(clauses), std::cref(renamings), std::ref(nextFirst), std::ref(total), std::ref(totalMutex)));
+	}
+	for (auto &th : threads) {
+		th.join();
+	}
+
+	printf("Enumerated %lld inputs, %lld up to renaming of the letters: %lld SATISFIABLE, %lld NOT SATISFIABLE, %lld over the limits\n\n",
+		total.enumerated, total.checked, total.satisfied, total.checked - total.satisfied - total.exceeded, total.exceeded);
+	if (total.invalid > 0) {
+		printf("%lld models failed the verification\n\n", total.invalid);
+	}
+	printEnumeratedInputs("Hardest inputs", total.hardest, inputTemplate, clauses);
+	printEnumeratedInputs("Largest minimal models", total.largest, inputTemplate, clauses);
+
+	return 0;
+}
+
 void printPropertyError(InputClauses &phi, Model &model, int s, int t, int w, int z) {
 	stdout_mutex.lock();
 	fprint(stderr, phi);
@@ -209,30 +492,73 @@ std::vector<InputClauses> genInputBatch(int nClauses, int nLetters, int clauseLe
 	return batch;
 }
 
-void workerLoop(Case caseType, int numClauses, int numLetters, int clauseLen, int batchSize, int maxFalseClauses, bool autoStop) {
-	using namespace std::chrono;
-
-	while (true) {
-
-		auto batch = genInputBatch(numClauses, numLetters, clauseLen, batchSize, maxFalseClauses);
+// every time is ranked before it is classified, the outliers too, or the
+// percentile would only see the times under it; it only counts once there
+// are enough times to rank against
+bool isOutlier(double time, Outcome outcome) {
+	if (outlier_time <= 0 && outlier_percentile <= 0) return false;
+
+	std::lock_guard<std::mutex> lock(outlier_mutex);
+	bench_times.add(time);
+	if (outcome == TIMEOUT || outcome == MEMOUT) return true;
+	if (outlier_time > 0 && time > outlier_time) return true;
+	return outlier_percentile > 0 && bench_times.total > 20 &&
+		time > bench_times.percentile(outlier_percentile);
+}
 
-		for (auto &phi : batch) {
+void writeOutlier(InputClauses &phi, Case caseType, unsigned seed, long long index,
+	const Model &model, double time, const Stats &stats) {
+	std::string path = outlier_prefix + "-" + std::to_string(seed) + "-" + std::to_string(index) + ".horn";
+	FILE *fp = fopen(path.c_str(), "w");
+	if (!fp) {
+		fprintf(stderr, "Can't write the outlier to %s\n", path.c_str());
+		return;
+	}
 
-			auto t1 = high_resolution_clock::now();
-			Model model = check(phi, caseType);
-			auto t2 = high_resolution_clock::now();
+	fprintf(fp, "# bench instance %lld of seed %u in the %s case: %s, size %d, %.7fs\n",
+		index, seed, caseStrings[caseType], outcomeStrings[model.outcome], (int)model.lo.size(), time);
+	fprintf(fp, "# replay with: horn --replay=%lld --seed=%u -l %d -c %d -m %s\n",
+		index, seed, (int)phi.labels.size() - 2, (int)phi.rules.size(), caseStrings[caseType]);
+	fprintf(fp, "# sizes %lld, saturations %lld, passes %lld, extends %lld, inserts %lld, firings %lld, pushes %lld\n",
+		stats.sizes, stats.saturations, stats.passes, stats.extends,
+		stats.labelInserts, stats.clauseFirings, stats.pendingPushes);
+	writeHorn(fp, phi);
+	fclose(fp);
+
+	printf("# instance %lld is an outlier, written to %s\n", index, path.c_str());
+}
 
-			double time = (duration_cast<duration<double>>(t2 - t1)).count();
-			printf("%d\t%d\t%d\t%s\t%.7f\n", 
-				(int)phi.labels.size()-2, (int)phi.rules.size(), 
-				(int)model.lo.size(), model.satisfied ? "YES" : "NO", time);
+void benchCheck(InputClauses &phi, Case caseType, unsigned seed, long long index) {
+	using namespace std::chrono;
 
-			checkMinimumModelAndLog(phi, model);
-		}
+	// the outliers are written with their stats, so they are always collected then
+	bool collect = print_stats || outlier_time > 0 || outlier_percentile > 0;
+	Stats stats = {};
+	auto t1 = high_resolution_clock::now();
+	Model model = check(phi, caseType, collect ? &stats : nullptr, check_limits);
+	auto t2 = high_resolution_clock::now();
+	outcome_counts[model.outcome]++;
+
+	double time = (duration_cast<duration<double>>(t2 - t1)).count();
+	if (print_stats) {
+		printf("%d\t%d\t%d\t%s\t%.7f\t%lld\t%d\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%.7f\t%.7f\t%.7f\t%.7f\t%lld\n", 
+			(int)phi.labels.size()-2, (int)phi.rules.size(), 
+			(int)model.lo.size(), outcomeStrings[model.outcome], time,
+			stats.sizes, stats.decidingSize, stats.saturations, stats.passes, stats.extends,
+			stats.labelInserts, stats.clauseFirings, stats.pendingPushes,
+			stats.setupTime, stats.initTime, stats.saturateTime, stats.extendTime, index);
+	} else {
+		printf("%d\t%d\t%d\t%s\t%.7f\t%lld\n", 
+			(int)phi.labels.size()-2, (int)phi.rules.size(), 
+			(int)model.lo.size(), outcomeStrings[model.outcome], time, index);
+	}
 
-		if (autoStop) return;
+	if (isOutlier(time, model.outcome)) {
+		writeOutlier(phi, caseType, seed, index, model, time, stats);
 	}
 
+	checkMinimumModelAndLog(phi, model);
+	verifyModelAndLog(phi, caseType, model, 1);
 }
 
 Case parseCaseType(const std::string &caseName) {
@@ -247,34 +573,71 @@ Case parseCaseType(const std::string &caseName) {
 void runCheckAndLog(InputClauses &phi, Case caseType) {
 	printf("Starting check of the %s case.\n", caseStrings[caseType]);
 
-	Model model = check(phi, caseType);
+	Stats stats = {};
+	Model model = check(phi, caseType, print_stats ? &stats : nullptr, check_limits);
 
 	if (model.satisfied) {
 		printf("The clause set is SATISFIABLE in the %s case, "
 			"with size %d and starting interval [%d, %d]\n", 
 			caseStrings[caseType], (int)model.lo.size(), 
 			model.start.first, model.start.second );
+	} else if (model.outcome == TIMEOUT) {
+		printf("The check of the %s case ran out of time\n", caseStrings[caseType]);
+	} else if (model.outcome == MEMOUT) {
+		printf("The check of the %s case ran out of memory\n", caseStrings[caseType]);
 	} else {
 		printf("The clause set is NOT SATISFIABLE in the %s case\n", caseStrings[caseType]);
 	}
+
+	verifyModelAndLog(phi, caseType, model, std::thread::hardware_concurrency());
+
+	if (export_fd >= 0 && model.satisfied) {
+		std::lock_guard<std::mutex> lock(export_mutex);
+		exportModel(phi, caseType, model, export_fd, export_format, export_passes);
+	}
+
+	if (print_stats) {
+		stdout_mutex.lock();
+		printf("Statistics of the %s case:\n", caseStrings[caseType]);
+		printStats(stdout, stats);
+		stdout_mutex.unlock();
+	}
 }
 
 int main(int argc, char **argv) {
-	std::random_device rd;
-	rng = std::mt19937(rd());
-
 	auto cmdl = argh::parser(argc, argv, 
 		argh::parser::PREFER_PARAM_FOR_UNREG_OPTION | 
 		argh::parser::SINGLE_DASH_IS_MULTIFLAG);
 
-	bool bench, verbose, autoStop;
-	std::string fileName, caseName;
+	bool bench, verbose, autoStop, suite, enumerate, sweep, diff, unsatCore;
+	std::string fileName, caseName, exportFile, exportFormat, orderName, traceFile, decodeFile, gridSpec;
+	std::string familyNames, familyParams, queriesFile;
 	int numThreads, numLetters, numClauses, batchSize, maxFalseClauses, clauseLen;
+	unsigned seed;
+	long long replay;
+	SuiteOptions suiteOptions;
+	EnumerateOptions enumerateOptions;
+	SweepOptions sweepOptions;
+	DiffOptions diffOptions;
+	CoreOptions coreOptions;
+	FamilyOptions familyOptions;
+	BatchOptions batchOptions;
 
 	// reading all command line parameters
 	bench = cmdl[{"-b", "--bench"}];
+	suite = cmdl[{"--suite"}];
+	enumerate = cmdl[{"--enumerate"}];
+	sweep = cmdl[{"--sweep"}];
+	diff = cmdl[{"--diff"}];
+	unsatCore = cmdl[{"--unsat_core", "--unsat-core"}];
 	autoStop = cmdl[{"-s", "--stop"}];
 	verbose = cmdl[{"-v", "--verbose"}];
+	print_stats = cmdl[{"--stats"}];
+	prune_symmetric = !cmdl[{"--no_symmetry"}];
+	small_engine = !cmdl[{"--no_small_engine"}];
+	refute_filter = !cmdl[{"--no_refute"}];
+	trace_all = cmdl[{"--trace_all"}];
+	export_passes = cmdl[{"--export_passes"}];
 	cmdl({"-f", "--file"}, "NOFILE") >> fileName;
 	cmdl({"-m", "--model_type"}, "FINITE") >> caseName;
 	if (!(cmdl({"-t", "--num_threads"}, 1) >> numThreads)) 
@@ -287,8 +650,93 @@ int main(int argc, char **argv) {
 		{ fprintf(stderr, "Pass a valid integer as the batch size\n"); return 1; }
 	if (!(cmdl({"--max_false_clauses"}, 0) >> maxFalseClauses)) 
 		{ fprintf(stderr, "Pass a valid integer as the max number of false clauses\n"); return 1; }
+	if (!(cmdl({"--refine"}, 3) >> sweepOptions.refine))
+		{ fprintf(stderr, "Pass a valid integer as the number of refinement rounds\n"); return 1; }
+	if (!(cmdl({"--top"}, 5) >> enumerateOptions.top))
+		{ fprintf(stderr, "Pass a valid integer as the number of inputs to report\n"); return 1; }
+	if (!(cmdl({"--time_limit"}, 0.0) >> check_limits.time))
+		{ fprintf(stderr, "Pass a valid number of seconds as the time limit\n"); return 1; }
+	if (!(cmdl({"--pass_limit"}, 0) >> check_limits.passes))
+		{ fprintf(stderr, "Pass a valid integer as the limit of saturation passes\n"); return 1; }
+	if (!(cmdl({"--memory_limit"}, 0.0) >> check_limits.memory))
+		{ fprintf(stderr, "Pass a valid number of megabytes as the memory limit\n"); return 1; }
 	if (!(cmdl({ "--clause_len" }, 4) >> clauseLen))
 		{ fprintf(stderr, "Pass a valid integer as the max number of false clauses\n"); return 1; }
+	if (!(cmdl({"--seed"}, suite ? 1U : std::random_device()()) >> seed))
+		{ fprintf(stderr, "Pass a valid unsigned integer as the seed\n"); return 1; }
+	if (!(cmdl({"--samples"}, 6) >> suiteOptions.samples))
+		{ fprintf(stderr, "Pass a valid integer as the number of samples per cell\n"); return 1; }
+	if (!(cmdl({"--warmup"}, 1) >> suiteOptions.warmup))
+		{ fprintf(stderr, "Pass a valid integer as the number of warmup runs\n"); return 1; }
+	if (!(cmdl({"--repeats"}, 5) >> suiteOptions.repeats) || suiteOptions.repeats < 1)
+		{ fprintf(stderr, "Pass a valid positive integer as the number of repeats\n"); return 1; }
+	if (!(cmdl({"--tolerance"}, suiteTolerance) >> suiteOptions.tolerance))
+		{ fprintf(stderr, "Pass a valid number as the regression tolerance\n"); return 1; }
+	if (!(cmdl({"--replay"}, -1) >> replay))
+		{ fprintf(stderr, "Pass a valid instance index to replay\n"); return 1; }
+	if (!(cmdl({"--outlier_time"}, 0.0) >> outlier_time))
+		{ fprintf(stderr, "Pass a valid number of seconds as the outlier time\n"); return 1; }
+	if (!(cmdl({"--outlier_percentile"}, 0.0) >> outlier_percentile) || outlier_percentile < 0 || outlier_percentile >= 100)
+		{ fprintf(stderr, "Pass a valid percentile below 100 as the outlier threshold\n"); return 1; }
+	cmdl({"--outlier_prefix"}, "outlier") >> outlier_prefix;
+	if (!(cmdl({"--instances"}, 1000) >> diffOptions.instances))
+		{ fprintf(stderr, "Pass a valid integer as the number of inputs to compare\n"); return 1; }
+	cmdl({"--diff_output"}, "disagreement.horn") >> diffOptions.outputFile;
+	cmdl({"--export"}, "") >> exportFile;
+	cmdl({"--export_format"}, "text") >> exportFormat;
+	cmdl({"--order"}, "lex") >> orderName;
+	cmdl({"--trace"}, "") >> traceFile;
+	cmdl({"--decode_trace"}, "") >> decodeFile;
+	gridSpec = cmdl({"--grid"}).str();
+	familyNames = cmdl({"--family"}).str();
+	cmdl({"--family_n"}, "1-8") >> familyParams;
+	cmdl({"--family_prefix"}, "") >> familyOptions.writePrefix;
+	cmdl({"--batch"}, "") >> queriesFile;
+	batchOptions.compare = cmdl[{"--batch_compare"}];
+	if (!(cmdl({"--saturate_threads"}, 1) >> saturate_threads) || saturate_threads < 1)
+		{ fprintf(stderr, "Pass a valid positive integer as the number of saturation threads\n"); return 1; }
+	if (!(cmdl({"--trace_size"}, 1 << 16) >> trace_capacity) || trace_capacity < 1)
+		{ fprintf(stderr, "Pass a valid positive integer as the number of trace events\n"); return 1; }
+	cmdl({"--baseline"}, "") >> suiteOptions.baselineFile;
+	cmdl({"--save_baseline"}, "") >> suiteOptions.saveBaselineFile;
+
+	rng = std::mt19937(seed);
+	suiteOptions.seed = seed;
+
+	candidate_order = parseCandidateOrder(orderName);
+	if (candidate_order == INVALID_ORDER)
+		{ fprintf(stderr, "Invalid candidate order, use: lex, ends, last\n"); return 1; }
+
+	if (suite) {
+		return runBenchSuite(suiteOptions);
+	}
+
+	if (!decodeFile.empty()) {
+		return decodeTrace(decodeFile);
+	}
+
+	// the spec is read from a file if there is one with that name
+	if (!gridSpec.empty()) {
+		std::ifstream specFile(gridSpec);
+		if (specFile) {
+			gridSpec.assign(std::istreambuf_iterator<char>(specFile), std::istreambuf_iterator<char>());
+		}
+		GridOptions gridOptions;
+		std::string error;
+		if (!parseGridSpec(gridSpec, gridOptions.spec, error))
+			{ fprintf(stderr, "Invalid grid spec, %s\n", error.c_str()); return 1; }
+		gridOptions.threads = numThreads;
+		gridOptions.seed = seed;
+		gridOptions.limits = check_limits;
+		return runGrid(gridOptions);
+	}
+
+	// opened before the other modes, so that they are traced as well
+	if (!traceFile.empty()) {
+		trace_fd = openExport(traceFile);
+		if (trace_fd < 0)
+			{ fprintf(stderr, "Can't open the trace file %s\n", traceFile.c_str()); return 1; }
+	}
 
 	for (auto & c: caseName) {
 		c = (char)toupper(c); 
@@ -296,15 +744,94 @@ int main(int argc, char **argv) {
 	Case caseType = parseCaseType(caseName);
 	if (caseType == INVALID_CASE) 
 		{ fprintf(stderr, "Invalid model type, use: FINITE, NATURAL, DISCRETE, ALL_CASES\n"); return 1; }
-	if (fileName == "NOFILE" && caseType == ALL_CASES) 
+
+	if (!familyNames.empty()) {
+		if (!parseFamilies(familyNames, familyOptions.families))
+			{ fprintf(stderr, "Invalid family, use: after, before, nested, split, edge_sat, edge_unsat, all\n"); return 1; }
+		if (!parseGridInts(familyParams, familyOptions.params) ||
+			std::any_of(familyOptions.params.begin(), familyOptions.params.end(), [](int n) { return n < 1; }))
+			{ fprintf(stderr, "Pass the family parameters as positive integers like 1,2,5-9\n"); return 1; }
+		if (caseType == ALL_CASES) familyOptions.cases = { FINITE, NATURAL, DISCRETE };
+		else familyOptions.cases = { caseType };
+		familyOptions.threads = numThreads;
+		familyOptions.limits = check_limits;
+		return runFamilies(familyOptions);
+	}
+
+	// the rules of the input file against every line of facts of the queries file
+	if (!queriesFile.empty()) {
+		if (fileName == "NOFILE")
+			{ fprintf(stderr, "Pass the rules of the queries with -f\n"); return 1; }
+		if (caseType == ALL_CASES)
+			{ fprintf(stderr, "Pass a single model type to check the queries in\n"); return 1; }
+		InputClauses phi = parseFile(fileName.c_str());
+		auto queries = parseQueries(queriesFile.c_str(), phi);
+		batchOptions.caseType = caseType;
+		batchOptions.threads = numThreads;
+		batchOptions.limits = check_limits;
+		return runBatch(phi, queries, batchOptions);
+	}
+	if (replay >= 0 && !cmdl.params().count("seed"))
+		{ fprintf(stderr, "Pass the seed of the bench run to replay with --seed\n"); return 1; }
+	if (fileName == "NOFILE" && caseType == ALL_CASES && !diff && replay < 0) 
 		{ fprintf(stderr, "You can't use ALL_CASES with random generated input\n"); return 1; }
 
+	if (diff) {
+		diffOptions.caseType = caseType;
+		diffOptions.letters = numLetters;
+		diffOptions.clauses = numClauses;
+		diffOptions.threads = numThreads;
+		diffOptions.enumerate = enumerate;
+		diffOptions.seed = seed;
+		diffOptions.limits = check_limits;
+		diffOptions.inputFile = fileName == "NOFILE" ? "" : fileName;
+		return runDiff(diffOptions);
+	}
+
+	if (enumerate) {
+		enumerateOptions.caseType = caseType;
+		enumerateOptions.letters = numLetters;
+		enumerateOptions.clauses = numClauses;
+		enumerateOptions.threads = numThreads;
+		return runEnumeration(enumerateOptions);
+	}
+
+	if (unsatCore) {
+		if (fileName == "NOFILE")
+			{ fprintf(stderr, "Pass the input file to extract the core from with -f\n"); return 1; }
+		InputClauses phi = parseFile(fileName.c_str());
+		coreOptions.caseType = caseType;
+		coreOptions.threads = numThreads;
+		coreOptions.limits = check_limits;
+		return runUnsatCore(phi, coreOptions);
+	}
+
+	if (sweep) {
+		sweepOptions.caseType = caseType;
+		sweepOptions.maxLetters = numLetters;
+		sweepOptions.maxClauses = numClauses;
+		sweepOptions.samples = suiteOptions.samples;
+		sweepOptions.threads = numThreads;
+		sweepOptions.seed = seed;
+		sweepOptions.limits = check_limits;
+		return runSweep(sweepOptions);
+	}
+
 	if (verbose) {
 		print_messages = true;
 	}
 
+	if (!exportFile.empty()) {
+		export_format = parseExportFormat(exportFormat);
+		if (export_format == INVALID_EXPORT)
+			{ fprintf(stderr, "Invalid export format, use: text, json, dot\n"); return 1; }
+		export_fd = openExport(exportFile);
+		if (export_fd < 0)
+			{ fprintf(stderr, "Can't open the export file %s\n", exportFile.c_str()); return 1; }
+	}
+
 	// in case no input file is provided, the input is generated automatically
-	if (fileName == "NOFILE") {
+	if (fileName == "NOFILE" && replay < 0) {
 
 		std::vector<std::string> labels;
 		FormulaVector symbols;
@@ -317,37 +844,57 @@ int main(int argc, char **argv) {
 		inputTemplate.facts.push_back(Formula::create(LETTER, 2));
 
 		if (bench) {
-			printf("%s\t%s\t%s\t%s\t%s\n", "NUM_LETTERS", "NUM_CLAUSES", "MODEL_SIZE", "SATISFIED", "TIME(s)");
-			std::vector<std::thread> threads;
-			for (int threadId = 0; threadId < numThreads; threadId++) {
-				std::thread th(workerLoop, caseType, numClauses, numLetters, clauseLen, batchSize, maxFalseClauses, autoStop);
-				threads.push_back(std::move(th));
+			printf("# seed %u\n", seed);
+			if (print_stats) {
+				printf("%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n", 
+					"NUM_LETTERS", "NUM_CLAUSES", "MODEL_SIZE", "SATISFIED", "TIME(s)",
+					"SIZES", "DECIDING_SIZE", "SATURATIONS", "PASSES", "EXTENDS", "INSERTS", "FIRINGS", "PUSHES",
+					"SETUP(s)", "INIT(s)", "SATURATE(s)", "EXTEND(s)", "INSTANCE");
+			} else {
+				printf("%s\t%s\t%s\t%s\t%s\t%s\n", "NUM_LETTERS", "NUM_CLAUSES", "MODEL_SIZE", "SATISFIED", "TIME(s)", "INSTANCE");
 			}
-			for (auto &th : threads) {
-				th.join();
+			// every instance is a task of its own, so that a slow instance only
+			// holds up one thread; the generator stays a few instances ahead.
+			// The instances are generated from the seed and their index, so
+			// --replay can generate any of them again
+			TaskPool pool(numThreads, 2 * numThreads);
+			for (long long i = 0; !autoStop || i < (long long)numThreads * batchSize; i++) {
+				auto phi = seededInput(seed, numLetters, numClauses, i);
+				pool.submit([phi, caseType, seed, i]() mutable { benchCheck(phi, caseType, seed, i); });
 			}
+			pool.wait();
+			printf("# %s %lld %s %lld %s %lld %s %lld\n",
+				outcomeStrings[SATISFIED], outcome_counts[SATISFIED].load(),
+				outcomeStrings[UNSATISFIED], outcome_counts[UNSATISFIED].load(),
+				outcomeStrings[TIMEOUT], outcome_counts[TIMEOUT].load(),
+				outcomeStrings[MEMOUT], outcome_counts[MEMOUT].load());
 
 		} else {
 			auto batch = genInputBatch(numClauses, numLetters, clauseLen, batchSize, maxFalseClauses);
+			TaskPool pool(numThreads, batch.size());
 			for (auto &phi : batch) {
-				runCheckAndLog(phi, caseType);
+				pool.submit([&phi, caseType] { runCheckAndLog(phi, caseType); });
 			}
+			pool.wait();
 
 		}
 
 	} else {
-		InputClauses phi = parseFile(fileName.c_str());
+		// a replayed bench instance is checked like an input file
+		InputClauses phi = replay >= 0 ? seededInput(seed, numLetters, numClauses, replay) : parseFile(fileName.c_str());
+		if (replay >= 0) {
+			printf("Bench instance %lld of seed %u:\n", replay, seed);
+			writeHorn(stdout, phi);
+			printf("\n");
+		}
 
 		// if the user wants to run all cases run then in different threads
 		if (caseType == ALL_CASES) {
-			std::vector<std::thread> threads;
-			threads.push_back(std::thread(runCheckAndLog, std::ref(phi), FINITE));
-			threads.push_back(std::thread(runCheckAndLog, std::ref(phi), NATURAL));
-			threads.push_back(std::thread(runCheckAndLog, std::ref(phi), DISCRETE));
-
-			for (auto &th : threads) {
-				th.join();
+			TaskPool pool(std::max(numThreads, 3), 3);
+			for (auto c : { FINITE, NATURAL, DISCRETE }) {
+				pool.submit([&phi, c] { runCheckAndLog(phi, c); });
 			}
+			pool.wait();
 
 		} else {
 			runCheckAndLog(phi, caseType);
@@ -355,18 +902,62 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	closeExport(export_fd);
+	closeExport(trace_fd);
 	return 0;
 }
 
-Model check(InputClauses &phi, Case caseType) {
-	int min, max;
+// the [A] and [P] literals of the input, checked by extend() at every pass,
+// and the compiled rules, shared by all the saturations
+void prepareState(State& state) {
+	InputClauses& phi = state.phi;
+	FormulaSet literals(phi.facts.begin(), phi.facts.end());
+	for (auto& clause : phi.rules) {
+		std::copy(clause.begin(), clause.end(), std::inserter(literals, literals.end()));
+	}
+	for (auto l : literals) {
+		if (l.type == BOXA) {
+			state.boxa.push_back(l);
+		} else if (l.type == BOXA_BAR) {
+			state.boxaBar.push_back(l);
+		}
+	}
+
+	compileRules(state, small_engine ? smallWords(phi) : 0);
+}
+
+// writes the model, or with passes the labels added by every pass of the
+// saturation that found it, which is run again with the exporter attached
+void exportModel(InputClauses& phi, Case caseType, const Model& model, int fd, ExportFormat format, bool passes) {
+	ModelExporter exporter(fd, format, phi);
+	exporter.begin(caseType, model.lo.size(), model.start);
+	if (passes) {
+		State state = {caseType, phi};
+		prepareState(state);
+		state.exporter = &exporter;
+		saturate(model.lo.size(), model.start.first, model.start.second, state);
+	} else {
+		exporter.write(model.lo);
+	}
+	exporter.end();
+}
+
+bool checkSizes(Case caseType, size_t rules, int& min, int& max) {
 	switch (caseType) {
 		case FINITE: min = 2; break;
 		case NATURAL: min = 3; break;
 		case DISCRETE: min = 4; break;
-		default: return Model::unsatisfied();
+		default: return false;
 	}
-	max = min + 6 * phi.rules.size(); 
+	max = min + 6 * rules;
+	return true;
+}
+
+// with a batch the rules come compiled, and every size starts from the
+// saturation of the rules alone
+Model checkInput(InputClauses &phi, Case caseType, RuleBatch *batch, Stats *stats, const Limits& limits) {
+	int min, max;
+	if (!checkSizes(caseType, phi.rules.size(), min, max)) return Model::unsatisfied();
 
 	if (print_messages) {
 		stdout_mutex.lock();
@@ -375,25 +966,28 @@ Model check(InputClauses &phi, Case caseType) {
 		stdout_mutex.unlock();
 	}
 
+	Budget budget(limits);
 	State state = {caseType, phi};
-	FormulaSet literals(phi.facts.begin(), phi.facts.end());
-	for (auto& clause : phi.rules) {
-		std::copy(clause.begin(), clause.end(), std::inserter(literals, literals.end()));
-	}
-	for (auto l : literals) {
-		if (l.type == BOXA) {
-			state.boxa.push_back(l);
-		} else if (l.type == BOXA_BAR) {
-			state.boxaBar.push_back(l);
-		}
+	state.stats = stats;
+	state.budget = Budget::enabled(limits) ? &budget : nullptr;
+	state.trace = traceRing();
+	if (state.trace) state.trace->clear();
+	{
+		PhaseTimer timer(stats ? &stats->setupTime : nullptr);
+		if (batch) batch->prepare(state);
+		else prepareState(state);
 	}
 
-	// if the case type is discrete we need to keep one point at the start
-	// free for the expand operation
-	int xmin = (caseType == DISCRETE) ? 1 : 0;
+	if (refute_filter && refute(state)) {
+		STAT_ADD(state, refutations, 1);
+		traceCheck(state, UNSATISFIED);
+		return Model::unsatisfied();
+	}
 
+	std::vector<Interval> candidates;
 	for (int k = min; k <= max; k++) {
-		int ymax = k - (caseType != FINITE);
+		STAT_ADD(state, sizes, 1);
+		if (stats) stats->decidingSize = k;
 
 		if (print_messages) {
 			stdout_mutex.lock();
@@ -401,149 +995,512 @@ Model check(InputClauses &phi, Case caseType) {
 			stdout_mutex.unlock();
 		}
 
-		for (int x = xmin; x < ymax - 1; x++) {
-			for (int y = x + 1; y < ymax; y++) {
-				Model solution = saturate(k, x, y, state);
-				if (solution.satisfied) {
-					return solution;
-				}
+		// a conflict of the rules alone is reached from every start
+		if (batch) {
+			state.seed = batch->seed(k);
+			if (state.seed && state.seed->conflict) continue;
+		}
+
+		startCandidates(k, state, candidates);
+		for (auto start : candidates) {
+			Outcome outcome;
+			if (state.budget && state.budget->exceeded(outcome)) {
+				traceCheck(state, outcome);
+				return Model::exceeded(outcome);
+			}
+
+			Model solution = saturateAny(k, start.first, start.second, state);
+			if (solution.outcome == SATISFIED) {
+				last_start = Interval(start.first, k - 1 - start.second);
+			}
+			if (solution.outcome != UNSATISFIED) {
+				traceCheck(state, solution.outcome);
+				return solution;
 			}
 		}
 	}
 
+	traceCheck(state, UNSATISFIED);
 	return Model::unsatisfied();
 }
 
-Model saturate(int d, int x, int y, const State& state) {
-	IntervalVector<FormulaVector> hi(d);
-	IntervalVector<FormulaSet> lo(d);
+Model check(InputClauses &phi, Case caseType, Stats *stats, const Limits& limits) {
+	return checkInput(phi, caseType, nullptr, stats, limits);
+}
 
-	for (int z = 0; z < d - 1; z++) {
-		for (int t = z + 1; t < d; t++) {
+Model check(InputClauses &phi, RuleBatch& batch, Stats *stats, const Limits& limits) {
+	return checkInput(phi, batch.caseType, &batch, stats, limits);
+}
 
-			lo.get(z, t).insert(Formula::truth());
+CandidateOrder parseCandidateOrder(const std::string& name) {
+	for (int i = 0; i < INVALID_ORDER; i++) {
+		if (name == candidateOrderStrings[i]) return (CandidateOrder)i;
+	}
+	return INVALID_ORDER;
+}
 
-			auto& hizt = hi.get(z, t);
-			for (auto i = 0U; i < state.phi.rules.size(); i++) {
-				hizt.push_back(Formula::create(CLAUSE, i));
-			}
+// the start intervals (x, y) of the models of size k, in the order of
+// candidate_order; all the orders try every size before the next one, so
+// the size found is always the minimal one
+void startCandidates(int k, const State& state, std::vector<Interval>& candidates) {
+	// if the case type is discrete we need to keep one point at the start
+	// free for the expand operation
+	int xmin = (state.caseType == DISCRETE) ? 1 : 0;
+	int ymax = k - (state.caseType != FINITE);
+
+	// in a finite model without [P] nothing looks left of x, so the points
+	// before it can be dropped and the same start satisfies the model of
+	// size k - x; without [A] the same holds for the points after y. Those
+	// smaller sizes were already refuted, so only x = 0 and y = k - 1 can
+	// satisfy, and the first start found in the lexicographic order stays
+	// the same
+	bool fromFirst = prune_symmetric && state.caseType == FINITE && state.boxaBar.empty();
+	bool toLast = prune_symmetric && state.caseType == FINITE && state.boxa.empty();
+
+	candidates.clear();
+	for (int x = xmin; x < ymax - 1; x++) {
+		if (fromFirst && x > xmin) break;
+		for (int y = x + 1; y < ymax; y++) {
+			if (toLast && y < ymax - 1) continue;
+			candidates.push_back(Interval(x, y));
+		}
+	}
+
+	if (candidate_order == ORDER_ENDS) {
+		std::stable_sort(candidates.begin(), candidates.end(), [=](Interval a, Interval b) {
+			return a.first - xmin + ymax - 1 - a.second < b.first - xmin + ymax - 1 - b.second;
+		});
+	} else if (candidate_order == ORDER_LAST && last_start.first >= 0) {
+		// the last start is kept as its distance to the two ends
+		Interval last(last_start.first, k - 1 - last_start.second);
+		auto it = std::find(candidates.begin(), candidates.end(), last);
+		if (it != candidates.end()) std::rotate(candidates.begin(), it, it + 1);
+	}
+}
+
+// the bits index every label of lo, so that membership tests and the whole
+// rows and columns read by [A] and [P] don't go through the hash sets
+inline bool addLabel(IntervalVector<LabelSet>& lo, TriangularBits& bits, int z, int t, Formula f, const State& state) {
+	if (!bits.set(literalIndex(f), z, t)) return false;
+	lo.get(z, t).insert(f);
+	TRACE(state, TRACE_INSERT, f, z, t);
+	STAT_ADD(state, labelInserts, 1);
+	if (state.budget) state.budget->bytes += labelBytes;
+	return true;
+}
+
+inline void addPending(FormulaVector& pending, Formula f, const State& state) {
+	pending.push_back(f);
+	STAT_ADD(state, pendingPushes, 1);
+	if (state.budget) state.budget->bytes += pendingBytes;
+}
 
+// A saturation pass is split in phases, and every phase in bands of 64 rows
+// dealt round-robin to the workers: the worker of the row z is the only one
+// writing the intervals [z, t] of hi and lo, the words of the row z in bits
+// and fired, and the word z / 64 of every column of bits. The [A] and [P]
+// labels reach other rows, so they are spread by a phase of their own once
+// every row is drained. With one worker the phases run on the calling thread
+// in the same order, so both modes reach the same fixpoint in the same passes.
+
+// a literal to put in the whole row or column of a point: p for a new [A]p
+// or [P]p label, or a universal [A]p or [P]p found at the point
+struct Spread {
+	int literal;
+	int point;
+	bool row;
+};
+
+struct SaturationWorker {
+	int id, workers;
+	const State *state;
+	Stats stats;
+	Budget budget;
+	std::unique_ptr<State> copy;  // with the stats and budget above, for the parallel workers
+	std::vector<Spread> spreads;
+	std::vector<const uint64_t*> rows;
+	bool changed, extended, conflict;
+
+	SaturationWorker(int id, int workers, const State& shared)
+		: id(id), workers(workers), state(&shared), stats(), budget(Limits()), changed(false), extended(false), conflict(false) {
+		if (workers == 1) return;
+		copy.reset(new State(shared));
+		copy->stats = shared.stats ? &stats : nullptr;
+		copy->budget = shared.budget ? &budget : nullptr;
+		copy->exporter = nullptr;
+		copy->trace = nullptr;
+		state = copy.get();
+	}
+
+	bool owns(int z) const { return (z >> 6) % workers == id; }
+
+	// f(from, to) on the rows of [begin, end) owned by the worker
+	template <typename F>
+	void forEachBand(int begin, int end, F f) const {
+		if (workers == 1) {
+			if (begin < end) f(begin, end);
+			return;
+		}
+		for (int c = (begin >> 6); (c << 6) < end; c++) {
+			if (c % workers != id) continue;
+			int from = std::max(begin, c << 6), to = std::min(end, (c + 1) << 6);
+			if (from < to) f(from, to);
 		}
 	}
 
-	auto& hixy = hi.get(x, y);
-	for (auto f : state.phi.facts) {
-		hixy.push_back(f);
+	// adds the counters of a parallel worker to the ones of the check
+	void merge(const State& shared) {
+		if (!copy) return;
+		if (shared.stats) {
+			*shared.stats += stats;
+			stats = Stats();
+		}
+		if (shared.budget) {
+			shared.budget->bytes += budget.bytes;
+			budget.bytes = 0;
+		}
 	}
+};
+
+struct Saturation {
+	int d;
+	IntervalVector<FormulaVector> hi;
+	IntervalVector<LabelSet> lo;
+	TriangularBits bits;
+
+	// the intervals where each rule already fired, in the layout of the rows
+	// of bits so that a rule is tested on the whole matrix in one pass
+	size_t block;
+	std::vector<uint64_t> fired;
+	std::vector<uint64_t> firing;
+
+	std::vector<std::unique_ptr<SaturationWorker>> team;
+
+	Saturation(int d, const State& state)
+		: d(d), hi(d), lo(d), bits(state.program.slots, state.program.indexed, d), block((size_t)d * bits.words),
+		fired(state.program.rules() * block), firing(block) {}
+};
+
+// the workers of the parallel saturations, one pool for the whole process so
+// that the threads of a bench or a batch don't start saturate_threads each;
+// the thread running the saturation is one of its workers as well
+TaskPool& saturatePool() {
+	static TaskPool pool(saturate_threads - 1, 4 * saturate_threads);
+	return pool;
+}
 
-	bool changed = true;
-	while (changed) {
-		changed = false;
+int saturationWorkers(int d, const State& state) {
+	// the trace keeps the order of the derivation, so it stays serial
+	if (saturate_threads <= 1 || state.trace) return 1;
+	return std::max(1, std::min(saturate_threads, (d + 63) >> 6));
+}
 
-		for (int z = 0; z < d -1; z++) {
-			for (int t = z + 1; t < d; t++) {
-				auto& hizt = hi.get(z, t);
-
-				for (auto ii = hizt.size(); ii-- > 0; ) {
-					auto f = hizt[ii];
-
-					if (f.type == LETTER && f.id == TRUTH) {
-						eraseFast(hizt, ii);
-
-					} else if (f.type == LETTER && f.id == FALSEHOOD) {
-						lo.get(z, t).insert(f);
-						return Model::unsatisfied();
-
-					} else if (f.type == LETTER) {
-						eraseFast(hizt, ii);
-						if (lo.get(z, t).insert(f).second) changed = true;
-
-					} else if (f.type == BOXA) {
-						eraseFast(hizt, ii);
-						if (lo.get(z, t).insert(f).second) changed = true;
-						for (int r = t + 1; r < d; r++) {
-							if (lo.get(t, r).insert(Formula::create(LETTER, f.id)).second) changed = true;
-							if (f.id == FALSEHOOD) return Model::unsatisfied();
-						}
-
-					} else if (f.type == BOXA_BAR) {
-						eraseFast(hizt, ii);
-						if (lo.get(z, t).insert(f).second) changed = true;
-						for (int r = 0; r < z; r++) {
-							if (lo.get(r, z).insert(Formula::create(LETTER, f.id)).second) changed = true;
-							if (f.id == FALSEHOOD) return Model::unsatisfied();
-						}
-
-					} else if (f.type == CLAUSE) {
-						Clause& clause = state.phi.rules[f.id];
-						Formula last = clause.back();
-						bool found = true;
-						auto& lozt = lo.get(z, t);
-						for (auto it = clause.begin(); it != clause.end()-1; it++) {
-							auto l = *it;
-							if (lozt.find(l) == lozt.end()) {
-								found = false;
-								break;
-							}
-						}
-
-						if (found) {
-							eraseFast(hizt, ii);
-							lozt.insert(f);
-							hizt.push_back(last); 
-							changed = true;
-						}
-					}
+// runs a phase on every worker, and returns when all of them are done
+void runPhase(Saturation& sat, const State& state, void (*phase)(Saturation&, SaturationWorker&)) {
+	if (sat.team.size() == 1) {
+		phase(sat, *sat.team[0]);
+		return;
+	}
+
+	// the pool is shared, so the phase waits for its own tasks only
+	std::mutex mutex;
+	std::condition_variable done;
+	size_t left = sat.team.size() - 1;
+	for (size_t i = 1; i < sat.team.size(); i++) {
+		SaturationWorker *w = sat.team[i].get();
+		saturatePool().submit([&sat, w, phase, &mutex, &done, &left] {
+			phase(sat, *w);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--left == 0) done.notify_one();
+		});
+	}
+	phase(sat, *sat.team[0]);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return left == 0; });
+	}
+	for (auto& worker : sat.team) {
+		worker->merge(state);
+	}
+}
 
+// moves the pending formulas of the row z to lo, returns false on a conflict
+bool drainRow(Saturation& sat, SaturationWorker& w, int z) {
+	const State& state = *w.state;
+	const RuleProgram& program = state.program;
+	const int falsehood = literalIndex(Formula::falsehood());
+	int d = sat.d;
+	bool conflict = false;
+	sat.hi.forEachInRow(z, z + 1, d, [&](int t, FormulaVector& hizt) {
+		if (conflict) return;
+
+		for (auto ii = hizt.size(); ii-- > 0; ) {
+			auto f = hizt[ii];
+			int l = literalIndex(f);
+			uint8_t action = program.actions[l];
+
+			if (action == RuleProgram::CONFLICT) {
+				sat.lo.get(z, t).insert(f);
+				TRACE(state, TRACE_CONFLICT, f, z, t);
+				conflict = true;
+				return;
+			}
+			eraseFast(hizt, ii);
+			if (action == RuleProgram::DROP) continue;
+
+			// [A]F and [P]F are a conflict unless the row or column they put F in is empty
+			bool row = action == RuleProgram::SPREAD_ROW;
+			if (program.targets[l] == falsehood && (row ? t + 1 < d : z > 0)) {
+				TRACE(state, TRACE_CONFLICT, f, z, t);
+				conflict = true;
+				return;
+			}
+			// a label already in lo was spread when it got there
+			if (!addLabel(sat.lo, sat.bits, z, t, f, state)) continue;
+			w.changed = true;
+			if (action == RuleProgram::LABEL) continue;
+			TRACE(state, TRACE_BROADCAST, f, z, t);
+			w.spreads.push_back({ program.targets[l], row ? t : z, row });
+		}
+	});
+	return !conflict;
+}
+
+void drainRows(Saturation& sat, SaturationWorker& w) {
+	w.changed = false;
+	w.conflict = false;
+	w.spreads.clear();
+	w.forEachBand(0, sat.d - 1, [&](int from, int to) {
+		for (int z = from; z < to && !w.conflict; z++) {
+			if (!drainRow(sat, w, z)) w.conflict = true;
+		}
+	});
+}
+
+// puts the literal of the spread in the intervals of its row or column that
+// belong to the worker, returns true if any of them didn't have it
+bool spread(Saturation& sat, SaturationWorker& w, const Spread& s) {
+	const State& state = *w.state;
+	Formula f = literalFormula(s.literal);
+	bool added = false;
+	if (s.row) {
+		if (!w.owns(s.point)) return false;
+		TriangularBits::forEachClear(sat.bits.row(s.literal, s.point), s.point + 1, sat.d, [&](int t) {
+			addLabel(sat.lo, sat.bits, s.point, t, f, state);
+			added = true;
+		});
+	} else {
+		w.forEachBand(0, s.point, [&](int from, int to) {
+			TriangularBits::forEachClear(sat.bits.col(s.literal, s.point), from, to, [&](int r) {
+				addLabel(sat.lo, sat.bits, r, s.point, f, state);
+				added = true;
+			});
+		});
+	}
+	return added;
+}
+
+// [A]p in [z, t] puts p in the row t, [P]p in [z, t] puts p in the column z
+void spreadLabels(Saturation& sat, SaturationWorker& w) {
+	for (auto& other : sat.team) {
+		for (auto& s : other->spreads) {
+			if (spread(sat, w, s)) w.changed = true;
+		}
+	}
+}
+
+// the rules are evaluated one at a time over the rows of the worker, the
+// heads are applied by the next pass
+void fireRules(Saturation& sat, SaturationWorker& w) {
+	const State& state = *w.state;
+	const RuleProgram& program = state.program;
+	size_t words = sat.bits.words;
+	for (int r = 0; r < program.rules(); r++) {
+		Formula head = literalFormula(program.heads[r]);
+		const uint64_t *known = sat.bits.row(program.heads[r], 0);
+		uint64_t *done = &sat.fired[r * sat.block];
+
+		w.forEachBand(0, sat.d, [&](int from, int to) {
+			size_t begin = from * words, end = to * words;
+			w.rows.clear();
+			for (auto l = program.bodyBegin(r); l != program.bodyEnd(r); l++) {
+				w.rows.push_back(sat.bits.row(*l, 0) + begin);
+			}
+			if (!andRows(w.rows.data(), w.rows.size(), done + begin, &sat.firing[begin], end - begin)) return;
+
+			// the heads already in lo have nothing left to do
+			for (size_t i = begin; i < end; i++) {
+				for (uint64_t word = sat.firing[i] & ~known[i]; word; word &= word - 1) {
+					int z = i / words;
+					int t = (i % words) * 64 + lowestBit(word);
+					addPending(sat.hi.get(z, t), head, state);
+					STAT_ADD(state, clauseFirings, 1);
+					TRACE(state, TRACE_FIRE, Formula::create(CLAUSE, r), z, t);
+					w.changed = true;
 				}
+				done[i] |= sat.firing[i];
+			}
+		});
+	}
+}
 
+// the points z where [A]p or [P]p holds everywhere; only reads the bits, so
+// that every worker sees them before any universal is applied
+void findUniversals(Saturation& sat, SaturationWorker& w) {
+	const State& state = *w.state;
+	int d = sat.d;
+	int min = state.caseType == DISCRETE ? 1 : 0;
+	int max = state.caseType == FINITE ? d : d - 1 - (state.caseType == NATURAL);
+	w.extended = false;
+	w.spreads.clear();
+	w.forEachBand(min, max, [&](int from, int to) {
+		for (int z = from; z < to; z++) {
+
+			// [A]p holds in every interval ending at z if p holds in the whole row z
+			for (auto& u : state.program.boxa) {
+				if (TriangularBits::full(sat.bits.row(u.second, z), z + 1, d)) {
+					TRACE(state, TRACE_BROADCAST, literalFormula(u.first), z, -1);
+					w.spreads.push_back({ u.first, z, false });
+				}
 			}
+
+			// [P]p holds in every interval starting at z if p holds in the whole column z
+			for (auto& u : state.program.boxaBar) {
+				if (TriangularBits::full(sat.bits.col(u.second, z), 0, z)) {
+					TRACE(state, TRACE_BROADCAST, literalFormula(u.first), z, -1);
+					w.spreads.push_back({ u.first, z, true });
+				}
+			}
+
+		}
+	});
+}
+
+void applyUniversals(Saturation& sat, SaturationWorker& w) {
+	for (auto& other : sat.team) {
+		for (auto& s : other->spreads) {
+			if (spread(sat, w, s)) w.extended = true;
+		}
+	}
+}
+
+Model saturate(int d, int x, int y, const State& state) {
+	STAT_ADD(state, saturations, 1);
+	PhaseTimer initTimer(state.stats ? &state.stats->initTime : nullptr);
+	Saturation sat(d, state);
+	auto& lo = sat.lo;
+
+	for (int z = 0; z < d - 1; z++) {
+		lo.forEachInRow(z, z + 1, d, [&](int t, LabelSet& lozt) {
+			lozt.insert(Formula::truth());
+			sat.bits.set(literalIndex(Formula::truth()), z, t);
+		});
+	}
+
+	int workers = saturationWorkers(d, state);
+	for (int i = 0; i < workers; i++) {
+		sat.team.push_back(std::unique_ptr<SaturationWorker>(new SaturationWorker(i, workers, state)));
+	}
+
+	if (state.budget) {
+		state.budget->bytes = d * (d + 1) / 2 * (intervalBytes + labelBytes) +
+			(2 * sat.bits.rowBits.size() + sat.fired.size()) * sizeof(uint64_t);
+	}
+
+	// the labels of the rules alone are closed already, nothing is spread again
+	if (state.seed) {
+		for (int z = 0; z < d - 1; z++) {
+			state.seed->lo.forEachInRow(z, z + 1, d, [&](int t, const LabelSet& labels) {
+				for (auto f : labels) addLabel(lo, sat.bits, z, t, f, state);
+			});
 		}
+	}
+	auto& hixy = sat.hi.get(x, y);
+	for (auto f : state.phi.facts) {
+		addPending(hixy, f, state);
+	}
+	TRACE(state, TRACE_START, Formula::create(CLAUSE, d), x, y);
+	initTimer.stop();
+
+	bool changed = true;
+	for (int pass = 0; changed; pass++) {
+		changed = false;
+		STAT_ADD(state, passes, 1);
 
-		int res = extend(d, hi, lo, state);
+		PhaseTimer passTimer(state.stats ? &state.stats->saturateTime : nullptr);
+		runPhase(sat, state, drainRows);
+		for (auto& w : sat.team) {
+			if (w->conflict) return Model::unsatisfied();
+		}
+		runPhase(sat, state, spreadLabels);
+		runPhase(sat, state, fireRules);
+		for (auto& w : sat.team) {
+			changed = changed || w->changed;
+		}
+		passTimer.stop();
+
+		STAT_ADD(state, extends, 1);
+		PhaseTimer extendTimer(state.stats ? &state.stats->extendTime : nullptr);
+		int res = extend(d, sat.hi, lo, sat.bits, state);
+		if (res != 2) {
+			runPhase(sat, state, findUniversals);
+			runPhase(sat, state, applyUniversals);
+			for (auto& w : sat.team) {
+				if (w->extended) res = 1;
+			}
+		}
+		extendTimer.stop();
 		changed = changed || (res == 1);
+		TRACE(state, TRACE_EXTEND, Formula::create(CLAUSE, pass), res, -1);
 
 		if (res == 2) {
 			return Model::unsatisfied();
 		}
+
+		if (state.exporter) {
+			state.exporter->write(lo, pass);
+		}
+
+		if (state.budget) {
+			Outcome outcome;
+			state.budget->passes++;
+			if (state.budget->exceeded(outcome)) {
+				return Model::exceeded(outcome);
+			}
+		}
 	}
 
 	if (print_messages) {
-		stdout_mutex.lock();
-		printState(state.phi, lo, d);
-		stdout_mutex.unlock();
+		std::lock_guard<std::mutex> lock(stdout_mutex);
+		ModelExporter exporter(1, EXPORT_TEXT, state.phi);
+		exporter.begin(state.caseType, d, Interval(x, y));
+		exporter.write(lo);
+		exporter.end();
 	}
 	return Model(lo, true, Interval(x, y));
 }
 
-int extend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<FormulaSet>& lo, const State& state) {
+// the boundary of the infinite cases, on the calling thread: the last point
+// repeats forever to the right, and in the discrete case the first one to the
+// left; the universals are then applied by the workers of saturate()
+int extend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<LabelSet>& lo, TriangularBits& bits, const State& state) {
 	int changed = false;
-	int min, max;
 
 	//printState(state.phi, lo, d);
 	//printState(state.phi, hi, d);
 
-	if (state.caseType == FINITE) {
-		min = 0;
-		max = d;
-	} else {
-		min = 0;
-		max = d - 2;
-
-		for (int z = min; z < max; z++) {
-			auto& hizm1 = hi.get(z, max+1);
-			for (auto f : hi.get(z, max)) {
-				if (f.type != CLAUSE) {
-					hizm1.push_back(f);
-					changed = 1;
-				}
-			}
-			auto& lozm1 = lo.get(z, max+1);
-			for (auto f : lo.get(z, max)) {
-				if (f.type != CLAUSE) {
-					if (lozm1.insert(f).second) changed = 1;
-				}
-			}
+	if (state.caseType != FINITE) {
+		int max = d - 2;
+
+		// the column max is mirrored to max+1, only the labels it doesn't
+		// have yet; the pending formulas get there as labels one pass later
+		for (int l = 0; l < bits.n; l++) {
+			if (!bits.indexed(l)) continue;
+			Formula f = literalFormula(l);
+			TriangularBits::forEachNew(bits.col(l, max), bits.col(l, max+1), 0, max, [&](int z) {
+				addLabel(lo, bits, z, max+1, f, state);
+				changed = 1;
+			});
 		}
 
 		std::vector<Formula> temp;
@@ -552,36 +1509,33 @@ int extend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<FormulaSet>&
 			if (f.type == LETTER) {
 				temp.push_back(Formula::create(BOXA, f.id));
 			} else if (f.type == BOXA) {
-				if (f.id == FALSEHOOD) return 2;
+				if (f.id == FALSEHOOD) {
+					TRACE(state, TRACE_CONFLICT, f, max, max+1);
+					return 2;
+				}
 				temp.push_back(Formula::create(LETTER, f.id));
 			} else if (f.type == BOXA_BAR) {
-				if (f.id == FALSEHOOD) return 2;
+				if (f.id == FALSEHOOD) {
+					TRACE(state, TRACE_CONFLICT, f, max, max+1);
+					return 2;
+				}
 				temp.push_back(Formula::create(LETTER, f.id));
 			}
 		}
 		for (auto f: temp) {
-			if (last.insert(f).second) changed = 1;
+			if (addLabel(lo, bits, max, max+1, f, state)) changed = 1;
 		}
 		temp.clear();
 
 		if (state.caseType == DISCRETE) {
-			min = 1;
-			max = d - 1;
-
-			for (int z = min + 1; z <= max; z++) {
-				auto& hi0z = hi.get(0, z);
-				for (auto f : hi.get(1, z)) {
-					if (f.type != CLAUSE) {
-						hi0z.push_back(f);
-						changed = 1;
-					}
-				}
-				auto& lo0z = lo.get(0, z);
-				for (auto f : lo.get(1, z)) {
-					if (f.type != CLAUSE) {
-						if (lo0z.insert(f).second) changed = 1;
-					}
-				}
+			// and the row 1 to the row 0
+			for (int l = 0; l < bits.n; l++) {
+				if (!bits.indexed(l)) continue;
+				Formula f = literalFormula(l);
+				TriangularBits::forEachNew(bits.row(l, 1), bits.row(l, 0), 2, d, [&](int z) {
+					addLabel(lo, bits, 0, z, f, state);
+					changed = 1;
+				});
 			}
 
 			auto& first = lo.get(0, 1);
@@ -589,54 +1543,24 @@ int extend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<FormulaSet>&
 				if (f.type == LETTER) {
 					temp.push_back(Formula::create(BOXA_BAR, f.id));
 				} else if (f.type == BOXA) {
-					if (f.id == FALSEHOOD) return 2;
+					if (f.id == FALSEHOOD) {
+						TRACE(state, TRACE_CONFLICT, f, 0, 1);
+						return 2;
+					}
 					temp.push_back(Formula::create(LETTER, f.id));
 				} else if (f.type == BOXA_BAR) {
-					if (f.id == FALSEHOOD) return 2;
+					if (f.id == FALSEHOOD) {
+						TRACE(state, TRACE_CONFLICT, f, 0, 1);
+						return 2;
+					}
 					temp.push_back(Formula::create(LETTER, f.id));
 				}
 			}
 			for (auto f: temp) {
-				if (first.insert(f).second) changed = 1;
+				if (addLabel(lo, bits, 0, 1, f, state)) changed = 1;
 			}
 		}
 	}
 
-	for (int z = min; z < max; z++) {
-
-		for (auto f : state.boxa) {
-			bool found = 1;
-			for (int t = z + 1; t < d; t++) {
-				auto p = Formula::create(LETTER, f.id);
-				if (lo.get(z, t).count(p) == 0) {
-					found = false;
-					break;
-				}
-			}
-			if (found) {
-				for (int r = 0; r < z; r++) {
-					if (lo.get(r, z).insert(f).second) changed = 1;
-				}
-			}
-		}
-
-		for (auto f : state.boxaBar) {
-			bool found = 1;
-			for (int r = 0; r < z; r++) {
-				auto p = Formula::create(LETTER, f.id);
-				if (lo.get(r, z).count(p) == 0) {
-					found = false;
-					break;
-				}
-			}
-			if (found) {
-				for (int t = z + 1; t < d; t++) {
-					if (lo.get(z, t).insert(f).second) changed = 1;
-				}
-			}
-		}
-
-	}
-
 	return changed;
 }
@@ -0,0 +1,102 @@
+
+#include "horn.hpp"
+
+// the pool and the queue of the worker running on this thread
+thread_local TaskPool *pool_owner = nullptr;
+thread_local int pool_worker = -1;
+
+TaskPool::TaskPool(int threads, size_t capacity)
+	: capacity(std::max(capacity, (size_t)1)), waiting(0), ready(0), unfinished(0), stopping(false), nextQueue(0) {
+	threads = std::max(threads, 1);
+	for (int i = 0; i < threads; i++) {
+		queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	}
+	for (int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(&TaskPool::worker, this, i));
+	}
+}
+
+TaskPool::~TaskPool() {
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto &th : workers) {
+		th.join();
+	}
+}
+
+void TaskPool::submit(Task task) {
+	// the workers never wait for space, or they could all wait for each other
+	bool own = pool_owner == this;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!own) space.wait(lock, [&] { return waiting < capacity; });
+		waiting++;
+		unfinished++;
+	}
+
+	// a worker keeps the tasks it submits, the others are spread around
+	size_t q = own ? pool_worker : nextQueue++ % queues.size();
+	{
+		std::lock_guard<std::mutex> lock(queues[q]->mutex);
+		queues[q]->tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready++;
+	}
+	wake.notify_one();
+}
+
+void TaskPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [&] { return unfinished == 0; });
+}
+
+// the newest task of the worker's own queue, or the oldest of another one
+bool TaskPool::take(int id, Task &task) {
+	int n = queues.size();
+	for (int i = 0; i < n; i++) {
+		auto &queue = *queues[(id + i) % n];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty()) continue;
+		if (i == 0) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		} else {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		return true;
+	}
+	return false;
+}
+
+void TaskPool::worker(int id) {
+	pool_owner = this;
+	pool_worker = id;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return ready > 0 || stopping; });
+			if (ready == 0) return;
+			ready--;
+			waiting--;
+		}
+		space.notify_one();
+
+		// the task counted by ready is already in some queue, and no other
+		// worker can take it without counting it first; a scan can still
+		// miss it while the others move, then the next one finds it
+		Task task;
+		while (!take(id, task)) std::this_thread::yield();
+		task();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--unfinished == 0) idle.notify_all();
+	}
+}
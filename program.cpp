@@ -0,0 +1,104 @@
+
+#include "horn.hpp"
+
+// The rules are turned into flat arrays once per check, so that the engines
+// read the bodies and heads of the rules as literal indices and decide what
+// a pending formula does with a table lookup instead of branching on its
+// type and letter. The bodies are also kept as bit masks for the small
+// engine when the literals fit in its words.
+
+void compileRules(State& state, int words) {
+	const InputClauses& phi = state.phi;
+	RuleProgram& program = state.program;
+	int literals = phi.labels.size() * 3;
+
+	program.bodyStart.assign(1, 0);
+	program.body.clear();
+	program.heads.clear();
+	for (auto& clause : phi.rules) {
+		for (auto it = clause.begin(); it != clause.end() - 1; it++) {
+			program.body.push_back(literalIndex(*it));
+		}
+		// an empty body holds everywhere, like T
+		if (clause.size() == 1) program.body.push_back(literalIndex(Formula::truth()));
+		program.bodyStart.push_back(program.body.size());
+		program.heads.push_back(literalIndex(clause.back()));
+	}
+
+	program.actions.assign(literals, RuleProgram::LABEL);
+	program.targets.assign(literals, -1);
+	for (int l = 0; l < literals; l++) {
+		Formula f = literalFormula(l);
+		if (f.type == BOXA || f.type == BOXA_BAR) {
+			program.actions[l] = f.type == BOXA ? RuleProgram::SPREAD_ROW : RuleProgram::SPREAD_COLUMN;
+			program.targets[l] = literalIndex(Formula::create(LETTER, f.id));
+		}
+	}
+	program.actions[literalIndex(Formula::truth())] = RuleProgram::DROP;
+	program.actions[literalIndex(Formula::falsehood())] = RuleProgram::CONFLICT;
+
+	compileBoxes(state);
+	indexLiterals(state);
+
+	program.words = words;
+	program.bodyMasks.assign(program.rules() * words, 0);
+	for (int r = 0; r < program.rules() && words; r++) {
+		for (auto l = program.bodyBegin(r); l != program.bodyEnd(r); l++) {
+			program.bodyMasks[r * words + (*l >> 6)] |= 1ULL << (*l & 63);
+		}
+	}
+}
+
+// the [A]p and [P]p of the state, with the letter p they look for
+void compileBoxes(State& state) {
+	RuleProgram& program = state.program;
+	program.boxa.clear();
+	program.boxaBar.clear();
+	for (auto f : state.boxa) {
+		program.boxa.push_back({ literalIndex(f), literalIndex(Formula::create(LETTER, f.id)) });
+	}
+	for (auto f : state.boxaBar) {
+		program.boxaBar.push_back({ literalIndex(f), literalIndex(Formula::create(LETTER, f.id)) });
+	}
+}
+
+// The labels of saturate() are the facts, the heads of the rules, T, the
+// letters of their [A]p and [P]p, and at the ends of the infinite cases the
+// [A]p, and [P]p in the discrete one, of the letters there. The other
+// literals never get a label, so only these and the ones the bodies read
+// have the bits of saturate(): with thousands of letters that occur only as
+// letters, that is a third of the bits in the finite case.
+void indexLiterals(State& state) {
+	RuleProgram& program = state.program;
+	int literals = state.phi.labels.size() * 3;
+	std::vector<bool> used(literals, false);
+	std::vector<int> added;
+	auto use = [&](int l) {
+		if (!used[l]) {
+			used[l] = true;
+			added.push_back(l);
+		}
+	};
+
+	use(literalIndex(Formula::truth()));
+	use(literalIndex(Formula::falsehood()));
+	for (auto f : state.phi.facts) use(literalIndex(f));
+	for (auto l : program.body) use(l);
+	for (auto l : program.heads) use(l);
+	while (!added.empty()) {
+		Formula f = literalFormula(added.back());
+		added.pop_back();
+		if (f.type != LETTER) {
+			use(literalIndex(Formula::create(LETTER, f.id)));
+			continue;
+		}
+		if (state.caseType != FINITE) use(literalIndex(Formula::create(BOXA, f.id)));
+		if (state.caseType == DISCRETE) use(literalIndex(Formula::create(BOXA_BAR, f.id)));
+	}
+
+	program.slots.assign(literals, -1);
+	program.indexed = 0;
+	for (int l = 0; l < literals; l++) {
+		if (used[l]) program.slots[l] = program.indexed++;
+	}
+}
@@ -0,0 +1,301 @@
+
+#include "horn.hpp"
+
+// The reference engine is a frozen copy of check(), saturate() and extend()
+// as they were before any performance work. It must not be optimized: the
+// differential mode compares every answer of the main engine against it.
+// It only keeps the budget checks, so that hard inputs can be skipped.
+
+inline bool referenceInsert(FormulaSet& labels, Formula f, const State& state) {
+	if (!labels.insert(f).second) return false;
+	if (state.budget) state.budget->bytes += labelBytes;
+	return true;
+}
+
+inline void referencePush(FormulaVector& pending, Formula f, const State& state) {
+	pending.push_back(f);
+	if (state.budget) state.budget->bytes += pendingBytes;
+}
+
+int referenceExtend(int d, IntervalVector<FormulaVector>& hi, IntervalVector<FormulaSet>& lo, const State& state) {
+	int changed = false;
+	int min, max;
+
+	if (state.caseType == FINITE) {
+		min = 0;
+		max = d;
+	} else {
+		min = 0;
+		max = d - 2;
+
+		for (int z = min; z < max; z++) {
+			auto& hizm1 = hi.get(z, max+1);
+			for (auto f : hi.get(z, max)) {
+				if (f.type != CLAUSE) {
+					referencePush(hizm1, f, state);
+					changed = 1;
+				}
+			}
+			auto& lozm1 = lo.get(z, max+1);
+			for (auto f : lo.get(z, max)) {
+				if (f.type != CLAUSE) {
+					if (referenceInsert(lozm1, f, state)) changed = 1;
+				}
+			}
+		}
+
+		std::vector<Formula> temp;
+		auto& last = lo.get(max, max+1);
+		for (auto f : last) {
+			if (f.type == LETTER) {
+				temp.push_back(Formula::create(BOXA, f.id));
+			} else if (f.type == BOXA) {
+				if (f.id == FALSEHOOD) return 2;
+				temp.push_back(Formula::create(LETTER, f.id));
+			} else if (f.type == BOXA_BAR) {
+				if (f.id == FALSEHOOD) return 2;
+				temp.push_back(Formula::create(LETTER, f.id));
+			}
+		}
+		for (auto f: temp) {
+			if (referenceInsert(last, f, state)) changed = 1;
+		}
+		temp.clear();
+
+		if (state.caseType == DISCRETE) {
+			min = 1;
+			max = d - 1;
+
+			for (int z = min + 1; z <= max; z++) {
+				auto& hi0z = hi.get(0, z);
+				for (auto f : hi.get(1, z)) {
+					if (f.type != CLAUSE) {
+						referencePush(hi0z, f, state);
+						changed = 1;
+					}
+				}
+				auto& lo0z = lo.get(0, z);
+				for (auto f : lo.get(1, z)) {
+					if (f.type != CLAUSE) {
+						if (referenceInsert(lo0z, f, state)) changed = 1;
+					}
+				}
+			}
+
+			auto& first = lo.get(0, 1);
+			for (auto f : first) {
+				if (f.type == LETTER) {
+					temp.push_back(Formula::create(BOXA_BAR, f.id));
+				} else if (f.type == BOXA) {
+					if (f.id == FALSEHOOD) return 2;
+					temp.push_back(Formula::create(LETTER, f.id));
+				} else if (f.type == BOXA_BAR) {
+					if (f.id == FALSEHOOD) return 2;
+					temp.push_back(Formula::create(LETTER, f.id));
+				}
+			}
+			for (auto f: temp) {
+				if (referenceInsert(first, f, state)) changed = 1;
+			}
+		}
+	}
+
+	for (int z = min; z < max; z++) {
+
+		for (auto f : state.boxa) {
+			bool found = 1;
+			for (int t = z + 1; t < d; t++) {
+				auto p = Formula::create(LETTER, f.id);
+				if (lo.get(z, t).count(p) == 0) {
+					found = false;
+					break;
+				}
+			}
+			if (found) {
+				for (int r = 0; r < z; r++) {
+					if (referenceInsert(lo.get(r, z), f, state)) changed = 1;
+				}
+			}
+		}
+
+		for (auto f : state.boxaBar) {
+			bool found = 1;
+			for (int r = 0; r < z; r++) {
+				auto p = Formula::create(LETTER, f.id);
+				if (lo.get(r, z).count(p) == 0) {
+					found = false;
+					break;
+				}
+			}
+			if (found) {
+				for (int t = z + 1; t < d; t++) {
+					if (referenceInsert(lo.get(z, t), f, state)) changed = 1;
+				}
+			}
+		}
+
+	}
+
+	return changed;
+}
+
+Model referenceSaturate(int d, int x, int y, const State& state) {
+	IntervalVector<FormulaVector> hi(d);
+	IntervalVector<FormulaSet> lo(d);
+
+	for (int z = 0; z < d - 1; z++) {
+		for (int t = z + 1; t < d; t++) {
+
+			lo.get(z, t).insert(Formula::truth());
+
+			auto& hizt = hi.get(z, t);
+			for (auto i = 0U; i < state.phi.rules.size(); i++) {
+				hizt.push_back(Formula::create(CLAUSE, i));
+			}
+
+		}
+	}
+
+	if (state.budget) {
+		state.budget->bytes = d * (d + 1) / 2 * (intervalBytes + labelBytes +
+			state.phi.rules.size() * pendingBytes);
+	}
+
+	auto& hixy = hi.get(x, y);
+	for (auto f : state.phi.facts) {
+		referencePush(hixy, f, state);
+	}
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+
+		for (int z = 0; z < d -1; z++) {
+			for (int t = z + 1; t < d; t++) {
+				auto& hizt = hi.get(z, t);
+
+				for (auto ii = hizt.size(); ii-- > 0; ) {
+					auto f = hizt[ii];
+
+					if (f.type == LETTER && f.id == TRUTH) {
+						eraseFast(hizt, ii);
+
+					} else if (f.type == LETTER && f.id == FALSEHOOD) {
+						lo.get(z, t).insert(f);
+						return Model::unsatisfied();
+
+					} else if (f.type == LETTER) {
+						eraseFast(hizt, ii);
+						if (referenceInsert(lo.get(z, t), f, state)) changed = true;
+
+					} else if (f.type == BOXA) {
+						eraseFast(hizt, ii);
+						if (referenceInsert(lo.get(z, t), f, state)) changed = true;
+						for (int r = t + 1; r < d; r++) {
+							if (referenceInsert(lo.get(t, r), Formula::create(LETTER, f.id), state)) changed = true;
+							if (f.id == FALSEHOOD) return Model::unsatisfied();
+						}
+
+					} else if (f.type == BOXA_BAR) {
+						eraseFast(hizt, ii);
+						if (referenceInsert(lo.get(z, t), f, state)) changed = true;
+						for (int r = 0; r < z; r++) {
+							if (referenceInsert(lo.get(r, z), Formula::create(LETTER, f.id), state)) changed = true;
+							if (f.id == FALSEHOOD) return Model::unsatisfied();
+						}
+
+					} else if (f.type == CLAUSE) {
+						Clause& clause = state.phi.rules[f.id];
+						Formula last = clause.back();
+						bool found = true;
+						auto& lozt = lo.get(z, t);
+						for (auto it = clause.begin(); it != clause.end()-1; it++) {
+							auto l = *it;
+							if (lozt.find(l) == lozt.end()) {
+								found = false;
+								break;
+							}
+						}
+
+						if (found) {
+							eraseFast(hizt, ii);
+							lozt.insert(f);
+							referencePush(hizt, last, state);
+							changed = true;
+						}
+					}
+
+				}
+
+			}
+		}
+
+		int res = referenceExtend(d, hi, lo, state);
+		changed = changed || (res == 1);
+
+		if (res == 2) {
+			return Model::unsatisfied();
+		}
+
+		if (state.budget) {
+			Outcome outcome;
+			state.budget->passes++;
+			if (state.budget->exceeded(outcome)) {
+				return Model::exceeded(outcome);
+			}
+		}
+	}
+
+	return Model(lo, true, Interval(x, y));
+}
+
+Model referenceCheck(InputClauses &phi, Case caseType, const Limits& limits) {
+	int min, max;
+	switch (caseType) {
+		case FINITE: min = 2; break;
+		case NATURAL: min = 3; break;
+		case DISCRETE: min = 4; break;
+		default: return Model::unsatisfied();
+	}
+	max = min + 6 * phi.rules.size();
+
+	Budget budget(limits);
+	State state = {caseType, phi};
+	state.budget = Budget::enabled(limits) ? &budget : nullptr;
+
+	FormulaSet literals(phi.facts.begin(), phi.facts.end());
+	for (auto& clause : phi.rules) {
+		std::copy(clause.begin(), clause.end(), std::inserter(literals, literals.end()));
+	}
+	for (auto l : literals) {
+		if (l.type == BOXA) {
+			state.boxa.push_back(l);
+		} else if (l.type == BOXA_BAR) {
+			state.boxaBar.push_back(l);
+		}
+	}
+
+	// if the case type is discrete we need to keep one point at the start
+	// free for the expand operation
+	int xmin = (caseType == DISCRETE) ? 1 : 0;
+
+	for (int k = min; k <= max; k++) {
+		int ymax = k - (caseType != FINITE);
+
+		for (int x = xmin; x < ymax - 1; x++) {
+			for (int y = x + 1; y < ymax; y++) {
+				Outcome outcome;
+				if (state.budget && state.budget->exceeded(outcome)) {
+					return Model::exceeded(outcome);
+				}
+
+				Model solution = referenceSaturate(k, x, y, state);
+				if (solution.outcome != UNSATISFIED) {
+					return solution;
+				}
+			}
+		}
+	}
+
+	return Model::unsatisfied();
+}
@@ -0,0 +1,52 @@
+
+#include "horn.hpp"
+
+// Every model has the facts in its start interval and the rules in all of
+// its intervals. Taking the letters, [A] and [P] literals of the start
+// interval as unrelated atoms, the unit propagation of the rules from the
+// facts only derives labels that saturate() would put there too, so a
+// conflict found this way refutes all the sizes at once. The propagation is
+// linear in the size of the rules: every rule counts the body literals it
+// still misses and fires when the count reaches zero.
+
+bool refute_filter = true;
+
+bool refute(const State& state) {
+	const InputClauses& phi = state.phi;
+	int n = phi.labels.size() * 3;
+
+	const RuleProgram& program = state.program;
+	std::vector<std::vector<int>> watches(n);  // the rules with the literal in the body
+	std::vector<int> missing(program.rules());
+	for (int r = 0; r < program.rules(); r++) {
+		for (auto l = program.bodyBegin(r); l != program.bodyEnd(r); l++) watches[*l].push_back(r);
+		missing[r] = program.bodyEnd(r) - program.bodyBegin(r);
+	}
+
+	// F is always a conflict, [A]F is one when there is always a later point
+	// and [P]F when there is always an earlier one
+	std::vector<bool> conflict(n);
+	conflict[literalIndex(Formula::falsehood())] = true;
+	conflict[literalIndex(Formula::create(BOXA, FALSEHOOD))] = state.caseType != FINITE;
+	conflict[literalIndex(Formula::create(BOXA_BAR, FALSEHOOD))] = state.caseType == DISCRETE;
+
+	std::vector<bool> known(n);
+	std::vector<int> queue;
+	auto derive = [&](int l) {
+		if (known[l]) return;
+		known[l] = true;
+		queue.push_back(l);
+	};
+
+	derive(literalIndex(Formula::truth()));
+	for (auto f : phi.facts) derive(literalIndex(f));
+	while (!queue.empty()) {
+		int l = queue.back();
+		queue.pop_back();
+		if (conflict[l]) return true;
+		for (auto r : watches[l]) {
+			if (--missing[r] == 0) derive(program.heads[r]);
+		}
+	}
+	return false;
+}
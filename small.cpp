@@ -0,0 +1,343 @@
+
+#include "horn.hpp"
+
+// The saturation of the instances whose literals fit in W words, which is
+// nearly all of the generated ones. Every interval holds its labels and its
+// pending formulas as W words each, the rule bodies are masks of the same
+// width and the intervals live in a square of the thread's arena that is
+// reused by the next saturation. The phases and the passes are the ones of
+// saturate() with a single worker, so both find the same model, and the trace
+// gets the same kinds of events, a word of labels at a time.
+
+bool small_engine = true;
+
+template <int W> struct SmallLabels {
+	uint64_t words[W];
+
+	bool test(int l) const { return (words[l >> 6] >> (l & 63)) & 1; }
+	void set(int l) { words[l >> 6] |= 1ULL << (l & 63); }
+	bool any() const {
+		uint64_t any = 0;
+		for (int i = 0; i < W; i++) any |= words[i];
+		return any != 0;
+	}
+	bool contains(const uint64_t *mask) const {
+		for (int i = 0; i < W; i++) {
+			if ((words[i] & mask[i]) != mask[i]) return false;
+		}
+		return true;
+	}
+	// adds the bits of other, and returns the ones that were new
+	SmallLabels merge(const SmallLabels& other) {
+		SmallLabels added;
+		for (int i = 0; i < W; i++) {
+			added.words[i] = other.words[i] & ~words[i];
+			words[i] |= other.words[i];
+		}
+		return added;
+	}
+	int count() const {
+		int n = 0;
+		for (int i = 0; i < W; i++) n += bitCount(words[i]);
+		return n;
+	}
+	template <typename F> void forEach(F f) const {
+		for (int i = 0; i < W; i++) {
+			for (uint64_t word = words[i]; word; word &= word - 1) f((i << 6) + lowestBit(word));
+		}
+	}
+	// the literals of the same letters with the type changed from one to the other
+	SmallLabels retype(FormulaType from, FormulaType to) const {
+		SmallLabels out = {};
+		forEach([&](int l) {
+			if (l % 3 == from) out.set(l - from + to);
+		});
+		return out;
+	}
+};
+
+template <int W> struct SmallSaturation {
+	int d;
+	SmallLabels<W> *lo, *hi;
+	std::vector<SmallLabels<W>> rowSpread, colSpread;  // the letters of new [A] and [P] labels
+	std::vector<SmallLabels<W>> universals[2];          // of [A] and [P], found at each point
+	long long inserts;
+	Stats *stats;
+	TraceRing *trace;
+
+	SmallSaturation(int d, const State& state)
+		: d(d), rowSpread(d), colSpread(d), inserts(0), stats(state.stats), trace(state.trace) {
+		static thread_local std::vector<SmallLabels<W>> arena;
+		arena.assign((size_t)2 * d * d, SmallLabels<W>());
+		lo = arena.data();
+		hi = lo + (size_t)d * d;
+		universals[0].resize(d);
+		universals[1].resize(d);
+	}
+	// the inserts are counted however the saturation ends, conflicts and limits too
+	~SmallSaturation() {
+		if (stats) stats->labelInserts += inserts;
+	}
+
+	SmallLabels<W>& at(SmallLabels<W> *v, int z, int t) { return v[(size_t)z * d + t]; }
+
+	bool add(int z, int t, const SmallLabels<W>& labels) {
+		SmallLabels<W> added = at(lo, z, t).merge(labels);
+		if (!added.any()) return false;
+		inserted(z, t, added);
+		return true;
+	}
+	void inserted(int z, int t, const SmallLabels<W>& added) {
+		inserts += added.count();
+		if (trace) added.forEach([&](int l) { record(TRACE_INSERT, l, z, t); });
+	}
+	void record(TraceEvent event, int l, int z, int t) {
+		if (trace) trace->record(event, literalFormula(l), z, t);
+	}
+
+	// the letters of the masks in the whole row z or column z
+	bool spreadRow(int z, const SmallLabels<W>& labels) {
+		bool changed = false;
+		for (int t = z + 1; t < d; t++) changed |= add(z, t, labels);
+		return changed;
+	}
+	bool spreadColumn(int z, const SmallLabels<W>& labels) {
+		bool changed = false;
+		for (int r = 0; r < z; r++) changed |= add(r, z, labels);
+		return changed;
+	}
+};
+
+// the pending formulas of every interval moved to lo, returns false on a conflict
+template <int W> bool smallDrain(SmallSaturation<W>& s, bool& changed) {
+	const int boxaFalse = literalIndex(Formula::create(BOXA, FALSEHOOD));
+	const int boxaBarFalse = literalIndex(Formula::create(BOXA_BAR, FALSEHOOD));
+	const int falsehood = literalIndex(Formula::falsehood());
+	int d = s.d;
+	for (int z = 0; z < d - 1; z++) {
+		for (int t = z + 1; t < d; t++) {
+			auto& pending = s.at(s.hi, z, t);
+			if (!pending.any()) continue;
+			int conflict = pending.test(falsehood) ? falsehood :
+				pending.test(boxaFalse) && t + 1 < d ? boxaFalse :
+				pending.test(boxaBarFalse) && z > 0 ? boxaBarFalse : -1;
+			if (conflict >= 0) {
+				s.record(TRACE_CONFLICT, conflict, z, t);
+				return false;
+			}
+
+			SmallLabels<W> added = s.at(s.lo, z, t).merge(pending);
+			pending = SmallLabels<W>();
+			if (!added.any()) continue;
+			s.inserted(z, t, added);
+			changed = true;
+
+			// [A]p in [z, t] puts p in the row t, [P]p in [z, t] puts p in the column z
+			SmallLabels<W> row = added.retype(BOXA, LETTER), col = added.retype(BOXA_BAR, LETTER);
+			if (s.trace) {
+				row.forEach([&](int l) { s.record(TRACE_BROADCAST, l - LETTER + BOXA, z, t); });
+				col.forEach([&](int l) { s.record(TRACE_BROADCAST, l - LETTER + BOXA_BAR, z, t); });
+			}
+			s.rowSpread[t].merge(row);
+			s.colSpread[z].merge(col);
+		}
+	}
+	return true;
+}
+
+template <int W> void smallSpread(SmallSaturation<W>& s, bool& changed) {
+	for (int z = 0; z < s.d; z++) {
+		if (s.rowSpread[z].any()) changed |= s.spreadRow(z, s.rowSpread[z]);
+		if (s.colSpread[z].any()) changed |= s.spreadColumn(z, s.colSpread[z]);
+		s.rowSpread[z] = SmallLabels<W>();
+		s.colSpread[z] = SmallLabels<W>();
+	}
+}
+
+// the heads of the rules whose body holds go to hi, unless they are in lo
+template <int W> void smallFire(SmallSaturation<W>& s, const State& state, bool& changed) {
+	const RuleProgram& program = state.program;
+	int rules = program.rules();
+	long long firings = 0;
+	for (int z = 0; z < s.d - 1; z++) {
+		for (int t = z + 1; t < s.d; t++) {
+			const auto& labels = s.at(s.lo, z, t);
+			for (int r = 0; r < rules; r++) {
+				int head = program.heads[r];
+				if (labels.test(head) || !labels.contains(&program.bodyMasks[r * W])) continue;
+				s.at(s.hi, z, t).set(head);
+				TRACE(state, TRACE_FIRE, Formula::create(CLAUSE, r), z, t);
+				firings++;
+			}
+		}
+	}
+	if (firings) changed = true;
+	STAT_ADD(state, clauseFirings, firings);
+	STAT_ADD(state, pendingPushes, firings);
+}
+
+// extend() on the masks, 2 on a conflict and 1 if a label was added
+template <int W> int smallExtend(SmallSaturation<W>& s, const State& state) {
+	int d = s.d;
+	int changed = 0;
+
+	// the boundary labels of [A]/[P] F are a conflict, the letters become [A]
+	// or [P] and the [A]/[P] labels become letters
+	auto boundary = [&](int z, int t, FormulaType box) {
+		SmallLabels<W> last = s.at(s.lo, z, t);
+		for (auto box : { BOXA, BOXA_BAR }) {
+			int l = literalIndex(Formula::create(box, FALSEHOOD));
+			if (!last.test(l)) continue;
+			s.record(TRACE_CONFLICT, l, z, t);
+			return false;
+		}
+		SmallLabels<W> labels = last.retype(LETTER, box);
+		labels.merge(last.retype(BOXA, LETTER));
+		labels.merge(last.retype(BOXA_BAR, LETTER));
+		if (s.add(z, t, labels)) changed = 1;
+		return true;
+	};
+
+	if (state.caseType != FINITE) {
+		int max = d - 2;
+
+		// the column max is mirrored to max+1
+		for (int z = 0; z < max; z++) {
+			if (s.add(z, max + 1, s.at(s.lo, z, max))) changed = 1;
+		}
+		if (!boundary(max, max + 1, BOXA)) return 2;
+
+		if (state.caseType == DISCRETE) {
+			// and the row 1 to the row 0
+			for (int z = 2; z < d; z++) {
+				if (s.add(0, z, s.at(s.lo, 1, z))) changed = 1;
+			}
+			if (!boundary(0, 1, BOXA_BAR)) return 2;
+		}
+	}
+
+	// [A]p holds in every interval ending at z if p holds in the whole row z,
+	// [P]p in every interval starting at z if p holds in the whole column z;
+	// all the points are found before any of them is applied
+	int min = state.caseType == DISCRETE ? 1 : 0;
+	int max = state.caseType == FINITE ? d : d - 1 - (state.caseType == NATURAL);
+	for (int z = min; z < max; z++) {
+		SmallLabels<W> row, col;
+		for (int i = 0; i < W; i++) row.words[i] = col.words[i] = ~0ULL;
+		for (int t = z + 1; t < d; t++) {
+			for (int i = 0; i < W; i++) row.words[i] &= s.at(s.lo, z, t).words[i];
+		}
+		for (int r = 0; r < z; r++) {
+			for (int i = 0; i < W; i++) col.words[i] &= s.at(s.lo, r, z).words[i];
+		}
+		SmallLabels<W> boxa = {}, boxaBar = {};
+		for (auto& u : state.program.boxa) {
+			if (row.test(u.second)) boxa.set(u.first);
+		}
+		for (auto& u : state.program.boxaBar) {
+			if (col.test(u.second)) boxaBar.set(u.first);
+		}
+		s.universals[0][z] = boxa;
+		s.universals[1][z] = boxaBar;
+	}
+	for (int z = min; z < max; z++) {
+		for (int i = 0; i < 2; i++) {
+			auto& universals = s.universals[i][z];
+			if (!universals.any()) continue;
+			if (s.trace) universals.forEach([&](int l) { s.record(TRACE_BROADCAST, l, z, -1); });
+			if (i == 0 ? s.spreadColumn(z, universals) : s.spreadRow(z, universals)) changed = 1;
+		}
+	}
+
+	return changed;
+}
+
+template <int W> Model saturateSmall(int d, int x, int y, const State& state) {
+	STAT_ADD(state, saturations, 1);
+	PhaseTimer initTimer(state.stats ? &state.stats->initTime : nullptr);
+	SmallSaturation<W> s(d, state);
+
+	SmallLabels<W> truth = {};
+	truth.set(literalIndex(Formula::truth()));
+	for (int z = 0; z < d - 1; z++) {
+		for (int t = z + 1; t < d; t++) {
+			s.at(s.lo, z, t) = truth;
+		}
+	}
+	// the labels of the rules alone are closed already, nothing is spread again
+	if (state.seed) {
+		memcpy(s.lo, state.seed->masks.data(), (size_t)d * d * sizeof(SmallLabels<W>));
+	}
+	if (state.budget) {
+		state.budget->bytes = (size_t)2 * d * d * sizeof(SmallLabels<W>);
+	}
+
+	auto& hixy = s.at(s.hi, x, y);
+	for (auto f : state.phi.facts) {
+		hixy.set(literalIndex(f));
+	}
+	STAT_ADD(state, pendingPushes, state.phi.facts.size());
+	TRACE(state, TRACE_START, Formula::create(CLAUSE, d), x, y);
+	initTimer.stop();
+
+	bool changed = true;
+	for (int pass = 0; changed; pass++) {
+		changed = false;
+		STAT_ADD(state, passes, 1);
+
+		PhaseTimer passTimer(state.stats ? &state.stats->saturateTime : nullptr);
+		if (!smallDrain(s, changed)) return Model::unsatisfied();
+		smallSpread(s, changed);
+		smallFire(s, state, changed);
+		passTimer.stop();
+
+		STAT_ADD(state, extends, 1);
+		PhaseTimer extendTimer(state.stats ? &state.stats->extendTime : nullptr);
+		int res = smallExtend(s, state);
+		extendTimer.stop();
+		changed = changed || (res == 1);
+		TRACE(state, TRACE_EXTEND, Formula::create(CLAUSE, pass), res, -1);
+		if (res == 2) return Model::unsatisfied();
+
+		if (state.budget) {
+			Outcome outcome;
+			state.budget->passes++;
+			if (state.budget->exceeded(outcome)) {
+				return Model::exceeded(outcome);
+			}
+		}
+	}
+	IntervalVector<LabelSet> lo(d);
+	for (int z = 0; z < d - 1; z++) {
+		lo.forEachInRow(z, z + 1, d, [&](int t, LabelSet& labels) {
+			s.at(s.lo, z, t).forEach([&](int l) { labels.insert(l); });
+		});
+	}
+
+	if (print_messages) {
+		std::lock_guard<std::mutex> lock(stdout_mutex);
+		ModelExporter exporter(1, EXPORT_TEXT, state.phi);
+		exporter.begin(state.caseType, d, Interval(x, y));
+		exporter.write(lo);
+		exporter.end();
+	}
+	return Model(lo, true, Interval(x, y));
+}
+
+// the words of a label set in saturateSmall(), or 0 if the literals don't fit
+int smallWords(const InputClauses& phi) {
+	size_t literals = phi.labels.size() * 3;
+	if (literals <= 64) return 1;
+	if (literals <= 128) return 2;
+	return 0;
+}
+
+Model saturateAny(int d, int x, int y, const State& state) {
+	// the large models split across threads stay with saturate()
+	if (saturationWorkers(d, state) > 1) return saturate(d, x, y, state);
+	switch (state.program.words) {
+		case 1: return saturateSmall<1>(d, x, y, state);
+		case 2: return saturateSmall<2>(d, x, y, state);
+		default: return saturate(d, x, y, state);
+	}
+}
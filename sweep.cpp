@@ -0,0 +1,158 @@
+
+#include "horn.hpp"
+
+struct SweepCell {
+	int letters;
+	int clauses;
+	std::vector<Outcome> outcomes;
+	std::vector<double> times;
+
+	double satProbability() const {
+		int answered = 0, satisfied = 0;
+		for (auto o : outcomes) {
+			if (o == SATISFIED || o == UNSATISFIED) answered++;
+			if (o == SATISFIED) satisfied++;
+		}
+		return answered ? (double)satisfied / answered : 0;
+	}
+
+	int exceeded() const {
+		int count = 0;
+		for (auto o : outcomes) {
+			if (o == TIMEOUT || o == MEMOUT) count++;
+		}
+		return count;
+	}
+};
+
+struct SweepJob {
+	int cell;
+	int sample;
+};
+
+void sweepWorker(const SweepOptions &options, std::vector<SweepCell> &cells, const std::vector<SweepJob> &jobs,
+	std::atomic<size_t> &nextJob, std::mutex &cellsMutex) {
+	using namespace std::chrono;
+
+	for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+		auto &job = jobs[i];
+		// the instances of a cell don't depend on the threads or the refinement rounds
+		auto phi = seededInput(options.seed, cells[job.cell].letters, cells[job.cell].clauses, job.sample);
+
+		auto t1 = high_resolution_clock::now();
+		Model model = check(phi, options.caseType, nullptr, options.limits);
+		auto t2 = high_resolution_clock::now();
+
+		std::lock_guard<std::mutex> lock(cellsMutex);
+		cells[job.cell].outcomes.push_back(model.outcome);
+		cells[job.cell].times.push_back((duration_cast<duration<double>>(t2 - t1)).count());
+	}
+}
+
+void runSweepJobs(const SweepOptions &options, std::vector<SweepCell> &cells, const std::vector<SweepJob> &jobs) {
+	std::atomic<size_t> nextJob(0);
+	std::mutex cellsMutex;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < options.threads; i++) {
+		threads.push_back(std::thread(sweepWorker, std::cref(options), std::ref(cells),
+			std::cref(jobs), std::ref(nextJob), std::ref(cellsMutex)));
+	}
+	for (auto &th : threads) {
+		th.join();
+	}
+}
+
+int hardestCell(const std::vector<SweepCell> &cells) {
+	int hardest = 0;
+	for (size_t i = 0; i < cells.size(); i++) {
+		if (median(cells[i].times) > median(cells[hardest].times)) hardest = i;
+	}
+	return hardest;
+}
+
+int runSweep(const SweepOptions &options) {
+	int rows = options.maxLetters;
+	int cols = options.maxClauses;
+
+	std::vector<SweepCell> cells;
+	for (int letters = 1; letters <= rows; letters++) {
+		for (int clauses = 1; clauses <= cols; clauses++) {
+			cells.push_back({ letters, clauses, {}, {} });
+		}
+	}
+
+	std::vector<SweepJob> jobs;
+	for (size_t cell = 0; cell < cells.size(); cell++) {
+		for (int sample = 0; sample < options.samples; sample++) {
+			jobs.push_back({ (int)cell, sample });
+		}
+	}
+	runSweepJobs(options, cells, jobs);
+
+	// every refinement round doubles the samples of the hardest cell and of
+	// its neighbours, the peak can move between rounds
+	for (int round = 0; round < options.refine; round++) {
+		int peak = hardestCell(cells);
+		int peakRow = peak / cols, peakCol = peak % cols;
+
+		jobs.clear();
+		for (int row = std::max(peakRow - 1, 0); row <= std::min(peakRow + 1, rows - 1); row++) {
+			for (int col = std::max(peakCol - 1, 0); col <= std::min(peakCol + 1, cols - 1); col++) {
+				int cell = row * cols + col;
+				int done = cells[cell].outcomes.size();
+				for (int sample = done; sample < 2 * done; sample++) {
+					jobs.push_back({ cell, sample });
+				}
+			}
+		}
+		runSweepJobs(options, cells, jobs);
+	}
+
+	int peak = hardestCell(cells);
+
+	printf("%s case, SAT%% / median time (ms) of each cell, * marks the hardest cell, "
+		"! the cells with samples over the limits\n", caseStrings[options.caseType]);
+	printf("%7s", "L\\C");
+	for (int col = 0; col < cols; col++) {
+		printf(" %14d", col + 1);
+	}
+	printf("\n");
+	for (int row = 0; row < rows; row++) {
+		printf("%7d", row + 1);
+		for (int col = 0; col < cols; col++) {
+			auto &cell = cells[row * cols + col];
+			printf(" %3.0f/%8.3f%c%c", 100 * cell.satProbability(), 1000 * median(cell.times),
+				row * cols + col == peak ? '*' : ' ', cell.exceeded() ? '!' : ' ');
+		}
+		printf("\n");
+	}
+
+	// the crossing is interpolated between the last cell above 50% and the first below
+	printf("\n%7s %9s %10s %13s %8s %10s\n", "LETTERS", "SAT50%", "PEAK_C", "PEAK_TIME(ms)", "SAMPLES", "OVER_LIMIT");
+	for (int row = 0; row < rows; row++) {
+		std::string crossing = "-";
+		for (int col = 0; col + 1 < cols; col++) {
+			double p1 = cells[row * cols + col].satProbability();
+			double p2 = cells[row * cols + col + 1].satProbability();
+			if (p1 >= 0.5 && p2 < 0.5) {
+				char buf[32];
+				snprintf(buf, sizeof(buf), "%.2f", col + 1 + (p1 - 0.5) / (p1 - p2));
+				crossing = buf;
+				break;
+			}
+		}
+
+		int rowPeak = row * cols;
+		int samples = 0, exceeded = 0;
+		for (int col = 0; col < cols; col++) {
+			auto &cell = cells[row * cols + col];
+			samples += cell.outcomes.size();
+			exceeded += cell.exceeded();
+			if (median(cell.times) > median(cells[rowPeak].times)) rowPeak = row * cols + col;
+		}
+		printf("%7d %9s %10d %13.3f %8d %10d\n", row + 1, crossing.c_str(),
+			cells[rowPeak].clauses, 1000 * median(cells[rowPeak].times), samples, exceeded);
+	}
+
+	return 0;
+}
@@ -1,88 +1,4 @@
 @echo off
-debug -b -m="discrete" -t=4 -l=1 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=2 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=3 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=4 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=1 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=2 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=3 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=4 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=2 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=2 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=3 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=4 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=3 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=5
-debug -b -m="discrete" -t=4 -l=2 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=5
-debug -b -m="discrete" -t=4 -l=3 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=5
-debug -b -m="discrete" -t=4 -l=4 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=5
-debug -b -m="discrete" -t=4 -l=5 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=5
-debug -b -m="discrete" -t=4 -l=6 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=5
-debug -b -m="discrete" -t=4 -l=7 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=4 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=2 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=3 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=4 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=5 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=2 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=3 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=4 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=6 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=2 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=3 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=4 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=7 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-
-debug -b -m="discrete" -t=4 -l=1 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=1
-debug -b -m="discrete" -t=4 -l=2 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=1
-debug -b -m="discrete" -t=4 -l=3 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=1
-debug -b -m="discrete" -t=4 -l=4 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=5 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=6 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=7 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=8 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=9 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
-debug -b -m="discrete" -t=4 -l=10 -c=8 --clause_len=3 --max_false_clauses=1 --stop --batch_size=25
+REM the bench mode never used --clause_len or --max_false_clauses, so the grid
+REM keeps the variable clause length the cells were measured with
+debug --grid="case=DISCRETE letters=1-10 clauses=1-8 samples=100" -t=4
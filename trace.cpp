@@ -0,0 +1,137 @@
+
+#include "horn.hpp"
+
+// The trace file is a sequence of dumps, one for every check that ran over
+// its limits, or for every check with --trace_all. A dump is a TraceHeader,
+// the labels of the input as a length followed by the characters, then the
+// records left in the ring from the oldest to the newest. The numbers are
+// written in the byte order of the machine that recorded them.
+
+struct TraceHeader {
+	char magic[4];
+	int32_t caseType;
+	int32_t outcome;
+	uint32_t labels;
+	uint64_t events;   // recorded by the check, the ring only keeps the last ones
+	uint64_t records;  // in this dump
+};
+
+std::mutex trace_mutex;
+int trace_fd = -1;
+size_t trace_capacity = 1 << 16;
+bool trace_all = false;
+thread_local std::unique_ptr<TraceRing> trace_ring;
+
+TraceRing *traceRing() {
+	if (trace_fd < 0) return nullptr;
+	if (!trace_ring) {
+		size_t capacity = 1;
+		while (capacity < trace_capacity) capacity *= 2;
+		trace_ring.reset(new TraceRing(capacity));
+	}
+	return trace_ring.get();
+}
+
+void traceDump(TraceRing *ring, const InputClauses& phi, Case caseType, Outcome outcome) {
+	uint64_t size = ring->records.size();
+	TraceHeader header = { {'H', 'T', 'R', 'C'}, caseType, outcome, (uint32_t)phi.labels.size(),
+		ring->next, std::min(ring->next, size) };
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	OutputBuffer out(trace_fd);
+	out.put((const char*)&header, sizeof(header));
+	for (auto& label : phi.labels) {
+		uint32_t len = label.size();
+		out.put((const char*)&len, sizeof(len));
+		out.put(label);
+	}
+	for (uint64_t i = ring->next - header.records; i < ring->next; i++) {
+		out.put((const char*)&ring->records[i & (size - 1)], sizeof(TraceRecord));
+	}
+}
+
+void traceCheck(const State& state, Outcome outcome) {
+	if (!state.trace) return;
+	if (trace_all || outcome == TIMEOUT || outcome == MEMOUT) {
+		traceDump(state.trace, state.phi, state.caseType, outcome);
+	}
+}
+
+std::string traceFormula(const std::vector<std::string>& labels, const TraceRecord& r) {
+	std::string name = r.id >= 0 && r.id < (int)labels.size() ? labels[r.id] : "#" + std::to_string(r.id);
+	if (r.type == BOXA) return "[A]" + name;
+	if (r.type == BOXA_BAR) return "[P]" + name;
+	return name;
+}
+
+void printRecord(const std::vector<std::string>& labels, const TraceRecord& r) {
+	std::string interval = intervalString(r.z, r.t);
+	switch (r.event) {
+		case TRACE_START:
+			printf("start size %d at %s\n", r.id, interval.c_str());
+			break;
+		case TRACE_INSERT:
+			printf("insert %s %s\n", interval.c_str(), traceFormula(labels, r).c_str());
+			break;
+		case TRACE_FIRE:
+			printf("fire %s rule %d\n", interval.c_str(), r.id);
+			break;
+		case TRACE_BROADCAST:
+			if (r.t < 0) printf("broadcast point %d %s\n", r.z, traceFormula(labels, r).c_str());
+			else printf("broadcast %s %s\n", interval.c_str(), traceFormula(labels, r).c_str());
+			break;
+		case TRACE_EXTEND:
+			printf("extend pass %d: %s\n", r.id, r.z == 2 ? "conflict" : r.z ? "changed" : "unchanged");
+			break;
+		case TRACE_CONFLICT:
+			printf("conflict %s %s\n", interval.c_str(), traceFormula(labels, r).c_str());
+			break;
+		default:
+			printf("unknown event %d\n", r.event);
+			break;
+	}
+}
+
+int decodeTrace(const std::string& path) {
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp) {
+		fprintf(stderr, "Can't open the trace file %s\n", path.c_str());
+		return 1;
+	}
+
+	bool valid = true;
+	TraceHeader header;
+	for (int dump = 1; valid && fread(&header, sizeof(header), 1, fp) == 1; dump++) {
+		if (memcmp(header.magic, "HTRC", 4) != 0 || header.caseType < FINITE || header.caseType > DISCRETE ||
+			header.outcome < UNSATISFIED || header.outcome > MEMOUT) {
+			valid = false;
+			break;
+		}
+
+		std::vector<std::string> labels;
+		for (uint32_t i = 0; valid && i < header.labels; i++) {
+			uint32_t len;
+			valid = fread(&len, sizeof(len), 1, fp) == 1;
+			std::string label(valid ? len : 0, ' ');
+			valid = valid && fread(&label[0], 1, len, fp) == len;
+			labels.push_back(label);
+		}
+
+		printf("dump %d: %s case, outcome %s, %llu events, the last %llu kept\n", dump,
+			caseStrings[header.caseType], outcomeStrings[header.outcome],
+			(unsigned long long)header.events, (unsigned long long)header.records);
+		TraceRecord r;
+		for (uint64_t i = 0; valid && i < header.records; i++) {
+			valid = fread(&r, sizeof(r), 1, fp) == 1;
+			if (valid) printRecord(labels, r);
+		}
+		printf("\n");
+	}
+
+	fclose(fp);
+	if (!valid) {
+		fprintf(stderr, "%s is not a trace file, or it is truncated\n", path.c_str());
+		return 1;
+	}
+	return 0;
+}
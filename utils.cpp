@@ -4,12 +4,12 @@
 void printFormula(FILE *stream, const InputClauses& phi, const Formula f, bool universal) {
 	auto prefix = universal ? "[U] " : "";
 	if (f.type == CLAUSE) {
-		Clause c = phi.rules[f.id];
+		const Clause& c = phi.rules[f.id];
 		for (auto& l : c) {
 			if (&l == &c.back())       fprintf(stream, "%s", " -> ");
 			else if (&l == &c.front()) fprintf(stream, "%s", prefix);
 			else                       fprintf(stream, "%s", " & ");
-			printFormula(phi, l, false);
+			printFormula(stream, phi, l, false);
 		}
 		return;
 
@@ -25,16 +25,29 @@ void printFormula(const InputClauses& phi, const Formula f, bool universal) {
 	printFormula(stdout, phi, f, universal);
 }
 
-void printInterval(FILE *stream, const InputClauses& phi, const Interval& interval, const FormulaSet& formulas) {
+// writes the clause set in the same syntax read by parseFile
+void writeHorn(FILE *stream, const InputClauses& phi) {
+	for (auto fact : phi.facts) {
+		printFormula(stream, phi, fact, false);
+		fprintf(stream, "\n");
+	}
+	fprintf(stream, "\n");
+	for (size_t i = 0; i < phi.rules.size(); i++) {
+		printFormula(stream, phi, Formula::create(CLAUSE, i), true);
+		fprintf(stream, "\n");
+	}
+}
+
+void printInterval(FILE *stream, const InputClauses& phi, const Interval& interval, const LabelSet& formulas) {
 	if (formulas.size() == 0) return;
 	fprintf(stream, "[%d, %d]: ",interval.first, interval.second);
 	for(auto f: formulas) {
 		fprintf(stream, "\n\t");
-		printFormula(phi, f, false);
+		printFormula(stream, phi, f, false);
 	}
 	fprintf(stream, "\n");
 }
-void printInterval(const InputClauses& phi, const Interval& interval, const FormulaSet& formulas) {
+void printInterval(const InputClauses& phi, const Interval& interval, const LabelSet& formulas) {
 	printInterval(stdout, phi, interval, formulas);
 }
 
@@ -43,7 +56,7 @@ void printInterval(FILE *stream, const InputClauses& phi, const Interval& interv
 	fprintf(stream, "[%d, %d]: ",interval.first, interval.second);
 	for(auto f: formulas) {
 		fprintf(stream, "\n\t");
-		printFormula(phi, f, false);
+		printFormula(stream, phi, f, false);
 	}
 	fprintf(stream, "\n");
 }
@@ -51,25 +64,23 @@ void printInterval(const InputClauses& phi, const Interval& interval, const Form
 	printInterval(stdout, phi, interval, formulas);
 }
 
-void printState(FILE *stream, const InputClauses& phi, IntervalVector<FormulaSet> &intervals, int d) {
+void printState(FILE *stream, const InputClauses& phi, IntervalVector<LabelSet> &intervals, int d) {
 	for (int z = 0; z < d - 1; z++) {
-		for (int t = z + 1; t < d; t++) {
-			auto i = intervals.get(z, t);
-			printInterval(phi, {z, t}, i);
-		}
+		intervals.forEachInRow(z, z + 1, d, [&](int t, const LabelSet& formulas) {
+			printInterval(stream, phi, {z, t}, formulas);
+		});
 	}
 	fprintf(stream, "\n");
 }
-void printState(const InputClauses& phi, IntervalVector<FormulaSet> &intervals, int d) {
+void printState(const InputClauses& phi, IntervalVector<LabelSet> &intervals, int d) {
 	printState(stdout, phi, intervals, d);
 }
 
 void printState(FILE *stream, const InputClauses& phi, IntervalVector<FormulaVector> &intervals, int d) {
 	for (int z = 0; z < d - 1; z++) {
-		for (int t = z + 1; t < d; t++) {
-			auto i = intervals.get(z, t);
-			printInterval(phi, {z, t}, i);
-		}
+		intervals.forEachInRow(z, z + 1, d, [&](int t, const FormulaVector& formulas) {
+			printInterval(stream, phi, {z, t}, formulas);
+		});
 	}
 	fprintf(stream, "\n");
 }
@@ -77,6 +88,38 @@ void printState(const InputClauses& phi, IntervalVector<FormulaVector> &interval
 	printState(stdout, phi, intervals, d);
 }
 
+Stats& Stats::operator+=(const Stats& other) {
+	sizes += other.sizes;
+	saturations += other.saturations;
+	passes += other.passes;
+	extends += other.extends;
+	labelInserts += other.labelInserts;
+	clauseFirings += other.clauseFirings;
+	pendingPushes += other.pendingPushes;
+	refutations += other.refutations;
+	setupTime += other.setupTime;
+	initTime += other.initTime;
+	saturateTime += other.saturateTime;
+	extendTime += other.extendTime;
+	decidingSize = std::max(decidingSize, other.decidingSize);
+	return *this;
+}
+
+void printStats(FILE *stream, const Stats& stats) {
+	fprintf(stream, "sizes tried:      %lld (deciding size %d)\n", stats.sizes, stats.decidingSize);
+	fprintf(stream, "saturations:      %lld\n", stats.saturations);
+	fprintf(stream, "passes:           %lld\n", stats.passes);
+	fprintf(stream, "extend calls:     %lld\n", stats.extends);
+	fprintf(stream, "label inserts:    %lld\n", stats.labelInserts);
+	fprintf(stream, "clause firings:   %lld\n", stats.clauseFirings);
+	fprintf(stream, "pending pushes:   %lld\n", stats.pendingPushes);
+	fprintf(stream, "refutations:      %lld\n", stats.refutations);
+	fprintf(stream, "setup time:       %.7fs\n", stats.setupTime);
+	fprintf(stream, "init time:        %.7fs\n", stats.initTime);
+	fprintf(stream, "saturate time:    %.7fs\n", stats.saturateTime);
+	fprintf(stream, "extend time:      %.7fs\n", stats.extendTime);
+}
+
 struct TokInfo {
 	int pos;
 	int len;
@@ -180,6 +223,7 @@ InputClauses parseFile(const char* path) {
 
 		bool hasNext = findToken(cline, token);
 		if (!hasNext) continue;
+		if (cline[token.pos] == '#') continue;
 		
 		if (line.substr(token.pos, token.len).compare("[U]") != 0) {
 			auto f = parseFormula(line, token, phi);
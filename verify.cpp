@@ -0,0 +1,256 @@
+#include "horn.hpp"
+
+// The verifier doesn't share any code with the saturation engine: it walks the
+// label sets of the model once into plain vectors of bools, and checks every
+// condition the minimal model has to respect on those, with none of the bit
+// matrices or word helpers of the engine, so that a bug in the engine or in
+// its helpers can't hide itself.
+
+struct VerifyState {
+	const InputClauses &phi;
+	Case caseType;
+	int d;
+	int literals;              // number of literal indices, three for each label
+	std::vector<bool> labels;  // the literal l of [z, t] at (l * d + z) * d + t
+	std::vector<bool> rows;    // the literal l in every [z, t] with t > z, at l * d + z
+	std::vector<bool> cols;    // the literal l in every [r, z] with r < z, at l * d + z
+	std::vector<std::vector<int>> bodies;
+	std::vector<int> heads;
+	std::vector<int> boxa, boxaBar;
+
+	VerifyState(const InputClauses &phi, Case caseType, int d)
+		: phi(phi), caseType(caseType), d(d), literals(phi.labels.size() * 3),
+		labels((size_t)literals * d * d), rows((size_t)literals * d), cols((size_t)literals * d) {}
+
+	bool has(int z, int t, int literal) const {
+		return labels[((size_t)literal * d + z) * d + t];
+	}
+	void set(int z, int t, int literal) {
+		labels[((size_t)literal * d + z) * d + t] = true;
+	}
+	bool fullRow(int literal, int z) const { return rows[(size_t)literal * d + z]; }
+	bool fullColumn(int literal, int z) const { return cols[(size_t)literal * d + z]; }
+
+	// the whole rows and columns, once every label is set
+	void fill() {
+		for (int l = 0; l < literals; l++) {
+			for (int z = 0; z < d; z++) {
+				bool row = true, col = true;
+				for (int t = z + 1; t < d && row; t++) row = has(z, t, l);
+				for (int r = 0; r < z && col; r++) col = has(r, z, l);
+				rows[(size_t)l * d + z] = row;
+				cols[(size_t)l * d + z] = col;
+			}
+		}
+	}
+};
+
+std::string intervalString(int z, int t) {
+	return "[" + std::to_string(z) + ", " + std::to_string(t) + "]";
+}
+
+std::string literalString(const InputClauses &phi, int literal) {
+	Formula f = literalFormula(literal);
+	const char *prefix = f.type == BOXA ? "[A]" : f.type == BOXA_BAR ? "[P]" : "";
+	return prefix + phi.labels[f.id];
+}
+
+// the range of points where the universal [A] and [P] conditions are enforced,
+// the others are the boundary points used to represent infinite models
+void universalRange(Case caseType, int d, int &min, int &max) {
+	switch (caseType) {
+		case NATURAL: min = 0; max = d - 2; break;
+		case DISCRETE: min = 1; max = d - 1; break;
+		default: min = 0; max = d; break;
+	}
+}
+
+// checks every interval starting at z, returns an empty string if all the
+// conditions hold
+std::string verifyRow(const VerifyState &vs, int z) {
+	int d = vs.d;
+	int min, max;
+	universalRange(vs.caseType, d, min, max);
+
+	for (int t = z + 1; t < d; t++) {
+		if (vs.has(z, t, literalIndex(Formula::falsehood()))) {
+			return "F holds at " + intervalString(z, t);
+		}
+
+		for (size_t i = 0; i < vs.bodies.size(); i++) {
+			bool satisfied = true;
+			for (auto literal : vs.bodies[i]) {
+				if (!vs.has(z, t, literal)) {
+					satisfied = false;
+					break;
+				}
+			}
+			if (satisfied && !vs.has(z, t, vs.heads[i])) {
+				return "rule " + std::to_string(i) + " is violated at " + intervalString(z, t);
+			}
+		}
+
+		for (int literal = 0; literal < vs.literals; literal++) {
+			if (!vs.has(z, t, literal)) continue;
+			Formula f = literalFormula(literal);
+			int p = literalIndex(Formula::create(LETTER, f.id));
+
+			if (f.type == BOXA && !vs.fullRow(p, t)) {
+				return literalString(vs.phi, literal) + " holds at " + intervalString(z, t) +
+					" but not every interval starting at " + std::to_string(t) + " has " + vs.phi.labels[f.id];
+			}
+			if (f.type == BOXA_BAR && !vs.fullColumn(p, z)) {
+				return literalString(vs.phi, literal) + " holds at " + intervalString(z, t) +
+					" but not every interval ending at " + std::to_string(z) + " has " + vs.phi.labels[f.id];
+			}
+		}
+	}
+
+	if (z < min || z >= max) return "";
+
+	// the [A] and [P] formulas of the input must be labeled everywhere they are true
+	for (auto a : vs.boxa) {
+		int p = literalIndex(Formula::create(LETTER, literalFormula(a).id));
+		if (vs.fullRow(p, z) && !vs.fullColumn(a, z)) {
+			return literalString(vs.phi, a) + " is true but missing in some interval ending at " + std::to_string(z);
+		}
+	}
+	for (auto a : vs.boxaBar) {
+		int p = literalIndex(Formula::create(LETTER, literalFormula(a).id));
+		if (vs.fullColumn(p, z) && !vs.fullRow(a, z)) {
+			return literalString(vs.phi, a) + " is true but missing in some interval starting at " + std::to_string(z);
+		}
+	}
+
+	return "";
+}
+
+// non-clause labels of [fz, ft] must also be in [tz, tt]
+std::string verifyCopy(const VerifyState &vs, int fz, int ft, int tz, int tt) {
+	for (int literal = 0; literal < vs.literals; literal++) {
+		if (vs.has(fz, ft, literal) && !vs.has(tz, tt, literal)) {
+			return "the labels of " + intervalString(fz, ft) + " are not copied to " + intervalString(tz, tt);
+		}
+	}
+	return "";
+}
+
+// the interval used to represent an infinite sequence of intervals must be
+// closed under the rules used by extend(), with letterModal being the modal
+// formula every letter implies there
+std::string verifyEndpoint(const VerifyState &vs, int z, int t, FormulaType letterModal) {
+	for (int id = 0; id < (int)vs.phi.labels.size(); id++) {
+		int p = literalIndex(Formula::create(LETTER, id));
+		int a = literalIndex(Formula::create(BOXA, id));
+		int b = literalIndex(Formula::create(BOXA_BAR, id));
+		int m = literalIndex(Formula::create(letterModal, id));
+
+		if (vs.has(z, t, p) && !vs.has(z, t, m)) {
+			return literalString(vs.phi, p) + " holds at " + intervalString(z, t) + " but " + literalString(vs.phi, m) + " doesn't";
+		}
+		if ((vs.has(z, t, a) || vs.has(z, t, b)) && !vs.has(z, t, p)) {
+			return "a modal formula on " + vs.phi.labels[id] + " holds at " + intervalString(z, t) + " but " + vs.phi.labels[id] + " doesn't";
+		}
+	}
+	return "";
+}
+
+std::string verifyBoundary(const VerifyState &vs) {
+	int d = vs.d;
+	if (vs.caseType == FINITE) return "";
+
+	int max = d - 2;
+	for (int z = 0; z < max; z++) {
+		auto error = verifyCopy(vs, z, max, z, max + 1);
+		if (!error.empty()) return error;
+	}
+	auto error = verifyEndpoint(vs, max, max + 1, BOXA);
+	if (!error.empty()) return error;
+
+	if (vs.caseType == DISCRETE) {
+		for (int z = 2; z < d; z++) {
+			error = verifyCopy(vs, 1, z, 0, z);
+			if (!error.empty()) return error;
+		}
+		error = verifyEndpoint(vs, 0, 1, BOXA_BAR);
+		if (!error.empty()) return error;
+	}
+
+	return "";
+}
+
+void verifyRows(const VerifyState &vs, int first, int step, std::string &error, int &errorRow) {
+	// the last point has no interval starting at it, but the universal
+	// conditions still apply to the intervals ending there
+	for (int z = first; z < vs.d; z += step) {
+		auto rowError = verifyRow(vs, z);
+		if (!rowError.empty()) {
+			error = rowError;
+			errorRow = z;
+			return;
+		}
+	}
+}
+
+std::string verifyModel(const InputClauses &phi, Case caseType, const Model &model, int threads) {
+	if (!model.satisfied) return "";
+
+	int d = model.lo.size();
+	VerifyState vs(phi, caseType, d);
+
+	for (int z = 0; z < d - 1; z++) {
+		for (int t = z + 1; t < d; t++) {
+			for (auto f : model.lo.get(z, t)) {
+				if (f.type == CLAUSE) continue;
+				vs.set(z, t, literalIndex(f));
+			}
+		}
+	}
+	vs.fill();
+
+	std::vector<bool> seen(vs.literals);
+	auto addLiteral = [&](Formula f) {
+		int literal = literalIndex(f);
+		if (seen[literal]) return;
+		seen[literal] = true;
+		if (f.type == BOXA) vs.boxa.push_back(literal);
+		if (f.type == BOXA_BAR) vs.boxaBar.push_back(literal);
+	};
+	for (auto &clause : phi.rules) {
+		std::vector<int> body;
+		for (auto it = clause.begin(); it != clause.end() - 1; it++) {
+			body.push_back(literalIndex(*it));
+			addLiteral(*it);
+		}
+		vs.bodies.push_back(body);
+		vs.heads.push_back(literalIndex(clause.back()));
+		addLiteral(clause.back());
+	}
+
+	int x = model.start.first, y = model.start.second;
+	for (auto f : phi.facts) {
+		addLiteral(f);
+		if (!vs.has(x, y, literalIndex(f))) {
+			return "the fact " + literalString(phi, literalIndex(f)) + " doesn't hold at " + intervalString(x, y);
+		}
+	}
+
+	auto error = verifyBoundary(vs);
+	if (!error.empty()) return error;
+
+	// the rows are interleaved between the threads since the first rows are the longest
+	threads = std::max(1, std::min(threads, (d - 1) / 8));
+	std::vector<std::string> errors(threads);
+	std::vector<int> errorRows(threads, d);
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threads; i++) {
+		workers.push_back(std::thread(verifyRows, std::cref(vs), i, threads, std::ref(errors[i]), std::ref(errorRows[i])));
+	}
+	verifyRows(vs, 0, threads, errors[0], errorRows[0]);
+	for (auto &th : workers) {
+		th.join();
+	}
+
+	auto first = std::min_element(errorRows.begin(), errorRows.end()) - errorRows.begin();
+	return errors[first];
+}